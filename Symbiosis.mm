@@ -39,16 +39,23 @@
 #include <AudioUnit/AudioUnit.h>
 #include <AudioToolbox/AudioUnitUtilities.h>
 #include <AudioToolbox/AudioToolbox.h>
+#include <CoreMIDI/MIDIServices.h>
 #include <mach-o/dyld.h>
 #include <mach-o/ldsyms.h>
 #include <mach/mach_time.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <libkern/OSAtomic.h>
 #include <stdio.h>
 #include <assert.h>
+#include <algorithm>
 #include <exception>
 #include <new>
 #include <map>
 #include <string>
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
 
 
 //------------------------------------------------------------------------------
@@ -230,8 +237,23 @@ static const int kMaxAURenderCallbacks = 128;
 static const int kMaxChannels = 32;
 static const int kMaxBuses = 32;
 static const int kMaxVSTMIDIEvents = 1024;
+static const int kMaxMIDIOutputEvents = 1024;
+static const int kSysExArenaSize = 64 * 1024;																			// Bytes of SysEx data that can be queued for the VST at once (larger dumps are rejected).
+static const int kMaxScheduledParameterEvents = 1024;
+static const int kParameterEventBatchSize = 64;																			// Immediate events of AudioUnitScheduleParameters() converted per scaleFromAUParameters() call.
+static const int kParameterQueueSize = 1024;																			// Must be a power of two.
+static const int kParameterCacheSweepCount = 8;																			// Parameters re-read from the VST per idle tick to catch changes it did not report.
+static const int kParameterCacheStaleReadCount = 64;																	// Max stale parameters re-read from the VST per idle tick (e.g. after a program change).
+static const float kDisplayStringQuantization = 4194304.0f;																// Steps in the VST 0 to 1 range that are considered different values by the display string cache (2^22).
+static const int kDisplayStringTraceInterval = 4096;																	// Display string lookups between each trace of the cache hit rate.
+static const int kParameterCacheMagic = 'SYPC';
+static const int kParameterCacheVersion = 2;																			// Increment when the layout of the compiled parameter mapping changes.
+static const int kParameterCacheHeaderSize = 7 * 4;
+static const int kParameterCacheEntrySize = 12 * 4;
+static const char* kParameterCacheSuffix = "SYParameters.cache";
+static const char* kGeneratedParametersSuffixFormat = "%08X.%d.SYParameters.txt";										// Generated SYParameters.txt when the AU bundle is not writable (VST version and parameter count first).
+static const int kMaxCurveTableSize = 64;																				// Max number of points in a table-lookup parameter curve.
 static const int kMaxFactoryPresets = 128;
-static const int kMaxMappedParameters = 1024;
 static const double kDefaultSampleRate = 44100.0;
 static const int kDefaultMaxFramesPerSlice = 4096;
 static const char* kAUPresetExtension = ".aupreset";
@@ -239,6 +261,10 @@ static const int kParametersFileNameChars = 16;
 static const ::UniChar kParametersFileName[kParametersFileNameChars] = {
 	'S', 'Y', 'P', 'a', 'r', 'a', 'm', 'e', 't', 'e', 'r', 's', '.', 't', 'x', 't'
 };
+static const int kMIDIMapFileNameChars = 13;
+static const ::UniChar kMIDIMapFileName[kMIDIMapFileNameChars] = {
+	'S', 'Y', 'M', 'I', 'D', 'I', 'M', 'a', 'p', '.', 't', 'x', 't'
+};
 static const int kFactoryPresetsFileNameChars = 20;
 static const ::UniChar kFactoryPresetsFileName[kFactoryPresetsFileNameChars] = {
 	'S', 'Y', 'F', 'a', 'c', 't', 'o', 'r', 'y', 'P', 'r', 'e', 's', 'e', 't', 's', '.', 't', 'x', 't'
@@ -374,6 +400,22 @@ static void checkIntInDictionary(::CFDictionaryRef dictionaryRef, ::CFStringRef
 	}
 }
 
+static int getOptionalIntInDictionary(::CFDictionaryRef dictionaryRef, ::CFStringRef keyRef, int defaultValue)
+		throw(SymbiosisException) {
+	SY_ASSERT(dictionaryRef != 0);
+	SY_ASSERT(keyRef != 0);
+	::CFTypeRef valueRef = ::CFDictionaryGetValue(dictionaryRef, keyRef);
+	if (valueRef == 0) {
+		return defaultValue;
+	}
+	if (::CFGetTypeID(valueRef) != ::CFNumberGetTypeID()) {
+		throw FormatException("Value in dictionary is not of expected type");
+	}
+	::SInt32 value = defaultValue;
+	::CFNumberGetValue(reinterpret_cast< ::CFNumberRef >(valueRef), kCFNumberSInt32Type, &value);
+	return value;
+}
+
 static const char* cfStringToCString(::CFStringRef stringRef, ::CFStringEncoding encoding, char buffer[]
 		, int maxStringLength) throw() {
 	SY_ASSERT(stringRef != 0);
@@ -476,6 +518,17 @@ static inline const char* eatSpace(const char* p) throw() {
 	return p;
 }
 
+// FNV-1a, used to detect changes to configuration files.
+static ::uint32_t hashBytes(const unsigned char* p, size_t size) throw() {
+	SY_ASSERT(size == 0 || p != 0);
+	
+	::uint32_t hash = 2166136261U;
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ p[i]) * 16777619U;
+	}
+	return hash;
+}
+
 #if (SY_DO_TRACE && SY_INCLUDE_GUI_SUPPORT && !SY_USE_COCOA_GUI)
 static void traceControlInfo(const char* s, ::ControlRef controlRef) throw(MacOSException) {
 	if (controlRef == 0) {
@@ -661,6 +714,239 @@ static void setGlobalTraceIdentifier(const char *name) {
 	gTraceIdentifierString[gTraceIdentifierStringLen - 1] = 0;
 }
 
+/* --- Sample conversion --- */
+
+/*
+	Stream sample formats that can be converted to and from the VST's float (or double) buffers. Integer samples are
+	signed, native-endian and packed (i.e. 24-bit samples occupy 3 bytes).
+*/
+enum SymbiosisSampleFormat {
+	kFloat32Samples
+	, kFloat64Samples
+	, kInt16Samples
+	, kInt24Samples
+	, kInt32Samples
+};
+
+static const double kInt16Scale = 32768.0;
+static const double kInt24Scale = 8388608.0;
+static const double kInt32Scale = 2147483648.0;
+
+static int quantizeSample(double sample, double scale) throw() {
+	const double scaled = std::max(-scale, std::min(scale - 1.0, sample * scale));
+	return static_cast<int>(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+/**
+	Reads sample \p index from \p source. Used for the formats and layouts that have no vectorized kernel below.
+*/
+static double decodeSample(SymbiosisSampleFormat format, const void* source, int index) throw() {
+	switch (format) {
+		case kFloat32Samples: return reinterpret_cast<const float*>(source)[index];
+		case kFloat64Samples: return reinterpret_cast<const double*>(source)[index];
+		case kInt16Samples: return reinterpret_cast<const ::SInt16*>(source)[index] / kInt16Scale;
+		case kInt24Samples: {
+			const unsigned char* p = reinterpret_cast<const unsigned char*>(source) + index * 3;
+		#if defined(__POWERPC__)
+			const int value = (p[0] << 16) | (p[1] << 8) | p[2];
+		#elif !defined(__POWERPC__)
+			const int value = p[0] | (p[1] << 8) | (p[2] << 16);
+		#endif
+			return ((value ^ 0x800000) - 0x800000) / kInt24Scale;														// Sign extend from 24 bits.
+		}
+		case kInt32Samples: return reinterpret_cast<const ::SInt32*>(source)[index] / kInt32Scale;
+	}
+	SY_ASSERT(0);
+	return 0.0;
+}
+
+/**
+	Writes \p sample to index \p index of \p destination, with clipping and rounding for integer formats.
+*/
+static void encodeSample(SymbiosisSampleFormat format, double sample, void* destination, int index) throw() {
+	switch (format) {
+		case kFloat32Samples: reinterpret_cast<float*>(destination)[index] = static_cast<float>(sample); break;
+		case kFloat64Samples: reinterpret_cast<double*>(destination)[index] = sample; break;
+		case kInt16Samples: reinterpret_cast< ::SInt16* >(destination)[index] = quantizeSample(sample, kInt16Scale); break;
+		case kInt24Samples: {
+			const int value = quantizeSample(sample, kInt24Scale);
+			unsigned char* p = reinterpret_cast<unsigned char*>(destination) + index * 3;
+		#if defined(__POWERPC__)
+			p[0] = static_cast<unsigned char>(value >> 16);
+			p[1] = static_cast<unsigned char>(value >> 8);
+			p[2] = static_cast<unsigned char>(value);
+		#elif !defined(__POWERPC__)
+			p[0] = static_cast<unsigned char>(value);
+			p[1] = static_cast<unsigned char>(value >> 8);
+			p[2] = static_cast<unsigned char>(value >> 16);
+		#endif
+			break;
+		}
+		case kInt32Samples: reinterpret_cast< ::SInt32* >(destination)[index] = quantizeSample(sample, kInt32Scale); break;
+	}
+}
+
+static void convertSamples(const double* source, float* destination, int count) throw() {
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		const __m128 low = _mm_cvtpd_ps(_mm_loadu_pd(source + i));
+		const __m128 high = _mm_cvtpd_ps(_mm_loadu_pd(source + i + 2));
+		_mm_storeu_ps(destination + i, _mm_movelh_ps(low, high));
+	}
+#endif
+	for (; i < count; ++i) {
+		destination[i] = static_cast<float>(source[i]);
+	}
+}
+
+static void convertSamples(const float* source, double* destination, int count) throw() {
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		const __m128 samples = _mm_loadu_ps(source + i);
+		_mm_storeu_pd(destination + i, _mm_cvtps_pd(samples));
+		_mm_storeu_pd(destination + i + 2, _mm_cvtps_pd(_mm_movehl_ps(samples, samples)));
+	}
+#endif
+	for (; i < count; ++i) {
+		destination[i] = source[i];
+	}
+}
+
+/**
+	Converts \p count samples of \p format from \p source into \p destination. \p stride is the distance (in samples)
+	between consecutive frames, i.e. the channel count for interleaved streams and 1 otherwise.
+*/
+static void decodeSamples(SymbiosisSampleFormat format, const void* source, int stride, float* destination, int count)
+		throw() {
+	int i = 0;
+	if (format == kFloat32Samples && stride == 1) {
+		memcpy(destination, source, sizeof (float) * count);
+		return;
+	} else if (format == kFloat64Samples && stride == 1) {
+		convertSamples(reinterpret_cast<const double*>(source), destination, count);
+		return;
+	}
+#if defined(__SSE2__)
+	if (format == kFloat32Samples && stride == 2) {
+		const float* s = reinterpret_cast<const float*>(source);
+		for (; i + 4 < count; i += 4) {																					// Stops one frame early so that the last load never reads past the end of the buffer.
+			const __m128 a = _mm_loadu_ps(s + i * 2);
+			const __m128 b = _mm_loadu_ps(s + i * 2 + 4);
+			_mm_storeu_ps(destination + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		}
+	} else if (format == kInt16Samples && stride == 1) {
+		const ::SInt16* s = reinterpret_cast<const ::SInt16*>(source);
+		const __m128 scale = _mm_set1_ps(static_cast<float>(1.0 / kInt16Scale));
+		for (; i + 8 <= count; i += 8) {
+			const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+			const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+			const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+			_mm_storeu_ps(destination + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+			_mm_storeu_ps(destination + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+		}
+	} else if (format == kInt32Samples && stride == 1) {
+		const ::SInt32* s = reinterpret_cast<const ::SInt32*>(source);
+		const __m128 scale = _mm_set1_ps(static_cast<float>(1.0 / kInt32Scale));
+		for (; i + 4 <= count; i += 4) {
+			const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+			_mm_storeu_ps(destination + i, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		destination[i] = static_cast<float>(decodeSample(format, source, i * stride));
+	}
+}
+
+static void decodeSamples(SymbiosisSampleFormat format, const void* source, int stride, double* destination
+		, int count) throw() {
+	if (format == kFloat64Samples && stride == 1) {
+		memcpy(destination, source, sizeof (double) * count);
+	} else if (format == kFloat32Samples && stride == 1) {
+		convertSamples(reinterpret_cast<const float*>(source), destination, count);
+	} else {
+		for (int i = 0; i < count; ++i) {
+			destination[i] = decodeSample(format, source, i * stride);
+		}
+	}
+}
+
+/**
+	Converts \p count samples from \p source into \p destination in \p format. \p stride is as for decodeSamples().
+*/
+static void encodeSamples(SymbiosisSampleFormat format, const float* source, void* destination, int stride, int count)
+		throw() {
+	int i = 0;
+	if (format == kFloat32Samples && stride == 1) {
+		memcpy(destination, source, sizeof (float) * count);
+		return;
+	} else if (format == kFloat64Samples && stride == 1) {
+		convertSamples(source, reinterpret_cast<double*>(destination), count);
+		return;
+	}
+#if defined(__SSE2__)
+	if (format == kInt16Samples && stride == 1) {
+		::SInt16* d = reinterpret_cast< ::SInt16* >(destination);
+		const __m128 scale = _mm_set1_ps(static_cast<float>(kInt16Scale));
+		const __m128 minimum = _mm_set1_ps(-1.0f);
+		const __m128 maximum = _mm_set1_ps(1.0f);
+		for (; i + 8 <= count; i += 8) {
+			const __m128 low = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i), minimum), maximum);
+			const __m128 high = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i + 4), minimum), maximum);
+			const __m128i lowSamples = _mm_cvtps_epi32(_mm_mul_ps(low, scale));
+			const __m128i highSamples = _mm_cvtps_epi32(_mm_mul_ps(high, scale));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_packs_epi32(lowSamples, highSamples));				// Saturates +1.0 (32768) to 32767.
+		}
+	} else if (format == kInt32Samples && stride == 1) {
+		::SInt32* d = reinterpret_cast< ::SInt32* >(destination);
+		const __m128 scale = _mm_set1_ps(static_cast<float>(kInt32Scale));
+		const __m128 minimum = _mm_set1_ps(static_cast<float>(-kInt32Scale));
+		const __m128 maximum = _mm_set1_ps(2147483520.0f);																// Largest float below 2^31.
+		for (; i + 4 <= count; i += 4) {
+			const __m128 samples = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(source + i), scale), minimum), maximum);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_cvtps_epi32(samples));
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		encodeSample(format, source[i], destination, i * stride);
+	}
+}
+
+static void encodeSamples(SymbiosisSampleFormat format, const double* source, void* destination, int stride
+		, int count) throw() {
+	if (format == kFloat64Samples && stride == 1) {
+		memcpy(destination, source, sizeof (double) * count);
+	} else if (format == kFloat32Samples && stride == 1) {
+		convertSamples(source, reinterpret_cast<float*>(destination), count);
+	} else {
+		for (int i = 0; i < count; ++i) {
+			encodeSample(format, source[i], destination, i * stride);
+		}
+	}
+}
+
+/**
+	Interleaves \p count frames from \p left and \p right into \p destination (the most common interleaved layout).
+*/
+static void interleaveStereo(const float* left, const float* right, float* destination, int count) throw() {
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		const __m128 l = _mm_loadu_ps(left + i);
+		const __m128 r = _mm_loadu_ps(right + i);
+		_mm_storeu_ps(destination + i * 2, _mm_unpacklo_ps(l, r));
+		_mm_storeu_ps(destination + i * 2 + 4, _mm_unpackhi_ps(l, r));
+	}
+#endif
+	for (; i < count; ++i) {
+		destination[i * 2] = left[i];
+		destination[i * 2 + 1] = right[i];
+	}
+}
+
 /* --- SymbiosisVstEvents --- */
 
 #if TARGET_API_MAC_CARBON && defined(__LP64__)
@@ -686,6 +972,15 @@ struct SymbiosisVstEvents {																								// Attention, this struct is
 	#pragma -a-
 #endif
 
+/**
+	Storage for one queued VST event. Every entry in SymbiosisVstEvents points to one of these (preallocated) so that
+	the same slot can hold either a short MIDI message or a SysEx dump.
+*/
+union SymbiosisVstEventStorage {
+	VstMidiEvent midi;
+	VstMidiSysexEvent sysex;
+};
+
 /**
 	SymbiosisAudioBufferList is a customization of AudioBufferList (with a fixed number of AudioBuffers) and must match
 	the AudioBufferList struct concerning field alignment etc.
@@ -695,6 +990,337 @@ struct SymbiosisAudioBufferList {
 	AudioBuffer	mBuffers[kMaxChannels];
 };
 
+/* --- SymbiosisParameterEvent --- */
+
+struct SymbiosisParameterEvent {
+	int offset;
+	int parameter;
+	float value;																										// Already scaled to the VST 0 to 1 range.
+};
+
+struct SymbiosisMIDIOutputEvent {
+	int offset;																											// Relative to the start of the current render call.
+	int length;
+	unsigned char data[4];
+};
+
+/* --- SymbiosisParameterQueue --- */
+
+/**
+	SymbiosisParameterQueue is a bounded lock-free queue for passing parameter changes from any number of threads to a
+	single consumer (the render thread). It is a ring of sequence-numbered slots, so producers never wait on each other
+	(or on the consumer) for longer than a failed compare-and-swap.
+*/
+class SymbiosisParameterQueue {
+	public:		SymbiosisParameterQueue();
+	public:		bool push(int parameter, float value);																	///< Returns false if the queue is full. Safe to call from any thread.
+	public:		bool pop(int& parameter, float& value);																	///< Returns false if the queue is empty. Must only be called from one thread at a time.
+	protected:	struct Slot {
+					volatile ::int32_t sequence;
+					int parameter;
+					float value;
+				};
+	protected:	volatile ::int32_t writePosition;
+	protected:	::int32_t readPosition;
+	protected:	Slot slots[kParameterQueueSize];
+};
+
+SymbiosisParameterQueue::SymbiosisParameterQueue() : writePosition(0), readPosition(0) {
+	for (int i = 0; i < kParameterQueueSize; ++i) {
+		slots[i].sequence = i;
+		slots[i].parameter = 0;
+		slots[i].value = 0.0f;
+	}
+}
+
+bool SymbiosisParameterQueue::push(int parameter, float value) {
+	::int32_t position = writePosition;
+	Slot* slot = 0;
+	while (true) {
+		slot = &slots[position & (kParameterQueueSize - 1)];
+		const ::int32_t difference = static_cast< ::int32_t >(static_cast< ::uint32_t >(slot->sequence)
+				- static_cast< ::uint32_t >(position));
+		if (difference == 0) {
+			if (::OSAtomicCompareAndSwap32Barrier(position, position + 1, &writePosition)) {
+				break;
+			}
+		} else if (difference < 0) {
+			return false;
+		}
+		position = writePosition;
+	}
+	slot->parameter = parameter;
+	slot->value = value;
+	::OSMemoryBarrier();
+	slot->sequence = position + 1;
+	return true;
+}
+
+bool SymbiosisParameterQueue::pop(int& parameter, float& value) {
+	Slot& slot = slots[readPosition & (kParameterQueueSize - 1)];
+	if (slot.sequence != readPosition + 1) {
+		return false;
+	}
+	::OSMemoryBarrier();
+	parameter = slot.parameter;
+	value = slot.value;
+	::OSMemoryBarrier();
+	slot.sequence = readPosition + kParameterQueueSize;
+	++readPosition;
+	return true;
+}
+
+/* --- SymbiosisParameterRamp --- */
+
+struct SymbiosisParameterRamp {
+	int parameter;
+	int startOffset;																									// Relative to the start of the current slice (negative if the ramp started in an earlier slice).
+	int durationFrames;
+	float startValue;																									// In AU units (ramps are linear in the AU range, whatever the parameter curve).
+	float endValue;																										// In AU units.
+	float endVSTValue;																									// endValue already scaled to the VST 0 to 1 range.
+};
+
+/**
+	SymbiosisParameterSmoothers holds the state of every parameter that has smoothing configured in SYParameters.txt as
+	parallel arrays (one element per smoothed parameter) so that all smoothers can be advanced in a single tight loop.
+	All values are in the VST 0 to 1 range.
+*/
+struct SymbiosisParameterSmoothers {
+	int count;
+	int* parameters;																									// VST parameter index.
+	float* times;																										// Smoothing time in seconds.
+	bool* isExponential;																								// One-pole curve with time constant times[i] if true, otherwise linear slope over times[i].
+	float* coefficients;																								// Fraction of the remaining distance covered per rampControlFrames (1 for linear curves).
+	float* maxSteps;																									// Largest change per rampControlFrames (1 for exponential curves).
+	float* current;
+	float* target;
+	float* sent;																										// Last value passed to the VST.
+};
+
+/* --- SymbiosisParameterCurves --- */
+
+/**
+	SymbiosisParameterCurves holds the compiled AU <-> VST transform of every mapped parameter (indexed by the slot in
+	SymbiosisComponent::parameterSlots) as parallel arrays. The normalized AU value n (0 to 1 between the AU min and
+	max) relates to the VST value v as follows:
+	
+		linear:		n = v											(steepness 0)
+		exp / log:	n = (e^(k * v) - 1) * c,	c = 1 / (e^k - 1)		(log is exp with k = ln(max / min))
+		power:		n = e^(k * ln(v)) = v^k						(isPower, c = 1, offset 0)
+		table:		piecewise linear through the n values of tableValues at evenly spaced v
+	
+	so that every analytic curve is evaluated with the same branch-free expression.
+*/
+struct SymbiosisParameterCurves {
+	float* minValues;																									// AU min value.
+	float* ranges;																										// AU max value - AU min value.
+	float* steepness;																									// k, 0 for linear curves.
+	float* scales;																										// c
+	float* offsets;																										// 1 for exp / log curves, 0 for power curves.
+	bool* isPower;
+	bool* isQuantized;																									// Round AU values to integers (boolean and indexed units).
+	int* tableStarts;																									// Index of the first point in tableValues, -1 if not a table curve.
+	int* tableSizes;
+	float* tableValues;
+	int tableValueCount;
+	int tableValueCapacity;																								// Allocated size of tableValues (grown geometrically).
+};
+
+static inline float normalizeVSTValue(const SymbiosisParameterCurves& curves, int i, float v) {
+	if (curves.tableStarts[i] >= 0) {
+		const float* table = curves.tableValues + curves.tableStarts[i];
+		const float x = v * (curves.tableSizes[i] - 1);
+		const int j = std::min(static_cast<int>(x), curves.tableSizes[i] - 2);
+		return table[j] + (table[j + 1] - table[j]) * (x - j);
+	}
+	if (curves.steepness[i] == 0.0f) {
+		return v;
+	}
+	const float x = (curves.isPower[i] ? logf(v) : v);
+	return std::min(std::max((expf(curves.steepness[i] * x) - curves.offsets[i]) * curves.scales[i], 0.0f), 1.0f);
+}
+
+static inline float denormalizeAUValue(const SymbiosisParameterCurves& curves, int i, float n) {
+	if (curves.tableStarts[i] >= 0) {
+		const float* table = curves.tableValues + curves.tableStarts[i];
+		int j = 0;
+		while (j < curves.tableSizes[i] - 2 && n > table[j + 1]) {
+			++j;
+		}
+		return (j + (n - table[j]) / (table[j + 1] - table[j])) / (curves.tableSizes[i] - 1);
+	}
+	if (curves.steepness[i] == 0.0f) {
+		return n;
+	}
+	const float y = logf(n / curves.scales[i] + curves.offsets[i]) / curves.steepness[i];
+	return std::min(std::max((curves.isPower[i] ? expf(y) : y), 0.0f), 1.0f);
+}
+
+/**
+	Parses the curve column of SYParameters.txt: "lin", "log", "exp<k>", "pow<k>" or a comma separated list of
+	increasing values from 0 to 1 (table-lookup). Returns false if \p spec is invalid for the \p minValue to
+	\p maxValue range. \p table must have room for kMaxCurveTableSize values.
+*/
+static bool parseParameterCurve(const char* spec, float minValue, float maxValue, float& steepness, bool& isPower
+		, float* table, int& tableSize) {
+	SY_ASSERT(spec != 0);
+	steepness = 0.0f;
+	isPower = false;
+	tableSize = 0;
+	char* e = 0;
+	if (strcmp(spec, "lin") == 0) {
+		return true;
+	} else if (strcmp(spec, "log") == 0) {
+		steepness = logf(maxValue / minValue);
+		return (minValue > 0.0f && maxValue > minValue);
+	} else if (strncmp(spec, "exp", 3) == 0) {
+		steepness = strtof(spec + 3, &e);
+		return ((*e) == '\0' && e != spec + 3 && steepness != 0.0f);
+	} else if (strncmp(spec, "pow", 3) == 0) {
+		steepness = strtof(spec + 3, &e);
+		isPower = true;
+		return ((*e) == '\0' && e != spec + 3 && steepness > 0.0f);
+	}
+	const char* p = spec;
+	while (tableSize < kMaxCurveTableSize) {
+		table[tableSize] = strtof(p, &e);
+		if (e == p || (tableSize > 0 && !(table[tableSize] > table[tableSize - 1]))) {
+			return false;
+		}
+		++tableSize;
+		if ((*e) == '\0') {
+			break;
+		} else if ((*e) != ',') {
+			return false;
+		}
+		p = e + 1;
+	}
+	return ((*e) == '\0' && tableSize >= 2 && table[0] == 0.0f && table[tableSize - 1] == 1.0f);
+}
+
+/* --- SymbiosisParameterMapping --- */
+
+/**
+	SymbiosisParameterMapping is one parsed line of SYParameters.txt. The strings point into the file (or cache image)
+	buffer and are only valid while it is.
+*/
+struct SymbiosisParameterMapping {
+	int vstParameterIndex;
+	::AudioUnitParameterUnit unit;
+	::AudioUnitParameterOptions flags;
+	float minValue;
+	float maxValue;
+	float defaultValue;
+	float smoothingTime;																								// In seconds, 0 for no smoothing.
+	bool smoothingIsExponential;
+	const char* name;
+	const char* unitName;																								// 0 if the parameter has no custom unit.
+	const char* choices;																								// '|' separated value strings, 0 if none.
+	const char* curve;																									// Curve column (see parseParameterCurve()), 0 for linear.
+};
+
+/*
+	The compiled parameter mapping (cache image) is a flat, offset-based layout (big-endian like our FXP / FXB code):
+	
+		header:		magic, version, source size, source hash, VST parameter count, entry count, strings size
+		entries:	vst param #, unit, flags, min, max, default, smoothing time, exponential, name offset, unit name
+					offset, choices offset, curve offset (offsets are relative to the strings block, -1 for none)
+		strings:	zero-terminated strings
+*/
+
+static int appendParameterCacheString(::CFMutableDataRef strings, const char* string) {
+	SY_ASSERT(strings != 0);
+	if (string == 0) {
+		return -1;
+	}
+	const int offset = static_cast<int>(::CFDataGetLength(strings));
+	::CFDataAppendBytes(strings, reinterpret_cast<const ::UInt8*>(string), strlen(string) + 1);
+	return offset;
+}
+
+static void appendParameterCacheEntry(::CFMutableDataRef entries, ::CFMutableDataRef strings
+		, const SymbiosisParameterMapping& mapping) {
+	SY_ASSERT(entries != 0);
+	SY_ASSERT(strings != 0);
+	unsigned char entry[kParameterCacheEntrySize];
+	unsigned char* p = entry;
+	p = writeBigInt32(p, mapping.vstParameterIndex);
+	p = writeBigInt32(p, mapping.unit);
+	p = writeBigInt32(p, mapping.flags);
+	p = writeBigFloat32(p, mapping.minValue);
+	p = writeBigFloat32(p, mapping.maxValue);
+	p = writeBigFloat32(p, mapping.defaultValue);
+	p = writeBigFloat32(p, mapping.smoothingTime);
+	p = writeBigInt32(p, (mapping.smoothingIsExponential ? 1 : 0));
+	p = writeBigInt32(p, appendParameterCacheString(strings, mapping.name));
+	p = writeBigInt32(p, appendParameterCacheString(strings, mapping.unitName));
+	p = writeBigInt32(p, appendParameterCacheString(strings, mapping.choices));
+	p = writeBigInt32(p, appendParameterCacheString(strings, mapping.curve));
+	SY_ASSERT(p == entry + kParameterCacheEntrySize);
+	::CFDataAppendBytes(entries, entry, kParameterCacheEntrySize);
+}
+
+static const char* getParameterCacheString(const char* strings, int stringsSize, int offset) throw(FormatException) {
+	if (offset == -1) {
+		return 0;
+	}
+	if (offset < 0 || offset >= stringsSize) {
+		throw FormatException("Invalid string offset in parameter cache");
+	}
+	return strings + offset;
+}
+
+static const unsigned char* readParameterCacheEntry(const unsigned char* p, const unsigned char* e, const char* strings
+		, int stringsSize, int vstParameterCount, SymbiosisParameterMapping& mapping)
+		throw(EOFException, FormatException) {
+	int unit = 0;
+	int flags = 0;
+	int isExponential = 0;
+	int nameOffset = 0;
+	int unitNameOffset = 0;
+	int choicesOffset = 0;
+	int curveOffset = 0;
+	p = readBigInt32(p, e, &mapping.vstParameterIndex);
+	p = readBigInt32(p, e, &unit);
+	p = readBigInt32(p, e, &flags);
+	p = readBigFloat32(p, e, &mapping.minValue);
+	p = readBigFloat32(p, e, &mapping.maxValue);
+	p = readBigFloat32(p, e, &mapping.defaultValue);
+	p = readBigFloat32(p, e, &mapping.smoothingTime);
+	p = readBigInt32(p, e, &isExponential);
+	p = readBigInt32(p, e, &nameOffset);
+	p = readBigInt32(p, e, &unitNameOffset);
+	p = readBigInt32(p, e, &choicesOffset);
+	p = readBigInt32(p, e, &curveOffset);
+	mapping.unit = static_cast< ::AudioUnitParameterUnit >(unit);
+	mapping.flags = static_cast< ::AudioUnitParameterOptions >(flags);
+	mapping.smoothingIsExponential = (isExponential != 0);
+	mapping.name = getParameterCacheString(strings, stringsSize, nameOffset);
+	mapping.unitName = getParameterCacheString(strings, stringsSize, unitNameOffset);
+	mapping.choices = getParameterCacheString(strings, stringsSize, choicesOffset);
+	mapping.curve = getParameterCacheString(strings, stringsSize, curveOffset);
+	float steepness;
+	bool isPower;
+	float table[kMaxCurveTableSize];
+	int tableSize;
+	if (mapping.vstParameterIndex < 0 || mapping.vstParameterIndex >= vstParameterCount || mapping.name == 0
+			|| !(mapping.minValue < mapping.maxValue) || !(mapping.smoothingTime >= 0.0f)
+			|| (mapping.curve != 0 && !parseParameterCurve(mapping.curve, mapping.minValue, mapping.maxValue
+			, steepness, isPower, table, tableSize))) {
+		throw FormatException("Invalid entry in parameter cache");
+	}
+	return p;
+}
+
+/* --- SymbiosisDisplayString --- */
+
+struct SymbiosisDisplayString {
+	::CFStringRef string;																								// Display string as returned from kAudioUnitProperty_ParameterStringFromValue, 0 if none is cached.
+	::int32_t quantizedValue;																							// VST value the string represents multiplied by kDisplayStringQuantization.
+	::int32_t generation;																								// VSTPlugIn::getParameterCacheGeneration() when the string was cached.
+};
+
 /* --- AUPropertyListener --- */
 
 struct AUPropertyListener {
@@ -703,6 +1329,10 @@ struct AUPropertyListener {
 	void* fListenerRefCon;
 };
 
+static bool propertyListenerPrecedes(const AUPropertyListener& listener, ::AudioUnitPropertyID id) {
+	return (listener.fPropertyID < id);
+}
+
 class VSTPlugIn;
 
 /**
@@ -721,6 +1351,7 @@ class VSTHost {
 	public:		virtual void idle(VSTPlugIn& plugIn) = 0;																///< The plug-in may issue this callback when it's GUI is busy, preventing the standard event loop from driving idling.
 	public:		virtual void updateDisplay(VSTPlugIn& plugIn) = 0;														///< Some fact about the plug-in has changed and this should be reflected in the GUI host. Most frequently used to indicate that a program name has changed.
 	public:		virtual void resizeWindow(VSTPlugIn& plugIn, VstInt32 width, VstInt32 height) = 0;						///< Plug-in is requesting that it's window should be resized.
+	public:		virtual void processEvents(VSTPlugIn& plugIn, const VstEvents& events) = 0;								///< Plug-in is sending events (typically MIDI) to the host. Normally called from within processReplacing(), with deltaFrames relative to the start of the block being processed.
 	public:		virtual ~VSTHost() { };
 };
 
@@ -730,14 +1361,17 @@ class VSTHost {
 class VSTPlugIn {
 	public:		VSTPlugIn(VSTHost& host, ::CFBundleRef bundleRef, float sampleRate = 44100.0f, VstInt32 blockSize = 0);	///< Construct a VST plug-in instance from the bundle referred to by \p bundleRef. Notice that the instance isn't usable until a successful call to open() has been made. \p host is your implementation of the host-interface with all the callbacks that the plug-in may use. \p sampleRate and \p blockSize are initial settings, you may set new rate and block-size with setSampleRate() and setBlockSize().
 	public:		bool isOpen() const;																					///< Returns true if the plug-in instance has been successfully opened. (May be called before open().)
+	public:		::CFBundleRef getBundleRef() const;																		///< Returns the (retained) bundle that this instance was constructed from. Use it to construct additional instances of the same plug-in.
 	public:		bool isEditorOpen() const;																				///< Returns true if the plug-in custom editor is currently open. (May be called before open().)
 	public:		bool isResumed() const;																					///< Returns true if the plug-in is currently in resumed / running state (i.e. not suspended). (May be called before open().)
 	public:		bool hasEditor() const;																					///< Returns true if the plug-in has implemented a custom editor. (May be called before open().)
 	public:		bool canProcessReplacing() const;																		///< Returns true if the processReplacing() function is supported. (May be called before open().)
+	public:		bool canProcessDoubleReplacing() const;																	///< Returns true if the processDoubleReplacing() function is supported. Always false when compiled with a VST SDK before 2.4. (May be called before open().)
 	public:		bool hasProgramChunks() const;																			///< Returns true if the plug-in wants to perform its own serialization of programs (and banks) as opposed to the host just storing program names and parameters. (May be called before open().)
 	public:		bool dontProcessSilence() const;																		///< Returns true if passing digital silence to the plug-in effect means that the output will also always be silent. (May be called before open().)
 	public:		VstInt32 getProgramCount() const;																		///< Returns the number of programs in a bank. You can expect the number of programs to stay constant during the life-time of the plug-in. (May be called before open().)
 	public:		VstInt32 getParameterCount() const;																		///< Returns the number of parameters. You can expect the number of parameters to stay constant during the life-time of the plug-in. (May be called before open().)
+	public:		VstInt32 getVersion() const;																			///< Returns the version of the plug-in.
 	public:		VstInt32 getInputCount() const;																			///< Returns the number of input channels. You can expect the number of input channels to stay constant during the life-time of the plug-in. (May be called before open().)
 	public:		VstInt32 getOutputCount() const;																		///< Returns the number of output channels. You can expect the number of output channels to stay constant during the life-time of the plug-in. (May be called before open().)
 	public:		VstInt32 getInitialDelay() const;																		///< Returns the latency of the plug-in in samples. You need to "preroll" audio and MIDI data for the plug-in by this many samples. (May be called before open().)
@@ -750,8 +1384,12 @@ class VSTPlugIn {
 	public:		void getCurrentProgramName(char programName[24 + 1]);													///< Obtains the name of the current program. The string is truncated to max 24 characters.
 	public:		void setCurrentProgramName(const char programName[24 + 1]);												///< Update the current program name to \p programName. Make sure the string is max 24 characters and null-terminated.
 	public:		bool getProgramName(VstInt32 programIndex, char programName[24 + 1]);									///< Obtains the name program name of a specific zero-based program index (without changing the current program selection). If false is returned, this method is not supported by the plug-in and you need to resort to using getCurrentProgram().
-	public:		float getParameter(VstInt32 parameterIndex);															///< Obtains the current parameter value of the zero-based parameter index. All VST parameter values are floating point between 0.0 and 1.0. \p parameterIndex must be less than the value returned by getParameterCount().
-	public:		void setParameter(VstInt32 parameterIndex, float value);												///< Updates the parameter \p parameterIndex to \p value. Notice that some plug-ins quantizes or limits parameter values, so a call to getParameter() after setting the parameter can be used to retrieve the actual parameter value set.
+	public:		float getParameter(VstInt32 parameterIndex);															///< Obtains the current parameter value of the zero-based parameter index. All VST parameter values are floating point between 0.0 and 1.0. \p parameterIndex must be less than the value returned by getParameterCount(). Values are cached, so this is normally just an array read (the plug-in is only called if the cached value may be stale). Safe to call from any thread.
+	public:		void setParameter(VstInt32 parameterIndex, float value);												///< Updates the parameter \p parameterIndex to \p value. Notice that some plug-ins quantizes or limits parameter values. getParameter() returns \p value until reconcileParameterCache() has re-read the actual value from the plug-in.
+	public:		void invalidateParameterCache();																		///< Makes the next getParameter() of every parameter read from the plug-in. Called automatically when programs or state are loaded or the plug-in requests a display update. Does not change getStateGeneration() by itself, values that turn out to differ when re-read do.
+	public:		::int32_t getParameterCacheGeneration() const;															///< Returns a number that is incremented every time invalidateParameterCache() is called. Use it to detect when data derived from parameter values (e.g. display strings) may be stale.
+	public:		::int32_t getStateGeneration() const;																	///< Returns a number that is incremented every time the plug-in state may have changed (parameter writes, automation, program changes and names, chunk loads and parameter or program changes that the plug-in did not report but that getParameter(), reconcileParameterCache() or getCurrentProgram() discovered). The program walk of createFXB() does not count. Use it to detect when a serialized state (e.g. from createFXB()) is stale.
+	public:		void reconcileParameterCache(int staleReadCount, int sweepCount);										///< Re-reads up to \p staleReadCount parameters that may be stale (continuing where the previous call stopped) plus \p sweepCount other parameters (in round-robin order) from the plug-in. Call periodically from a non-real-time thread (e.g. an idle timer) so that getParameter() rarely needs to call the plug-in.
 	public:		void getParameterName(VstInt32 parameterIndex, char parameterName[24 + 1]);								///< Obtains the name of parameter \p parameterIndex. You can expect the names of parameters to stay constant during the life-time of the plug-in. The VST spec says 8 characters max, but many VSTs don't care about that, so I say 24. :-)
 	public:		void getParameterDisplay(VstInt32 parameterIndex, char parameterDisplay[24 + 1]);						///< Obtains the current parameter value of \p parameterIndex as a human-readable string. The VST spec says 8 characters max, but many VSTs don't care about that, so I say 24. :-)
 	public:		void getParameterLabel(VstInt32 parameterIndex, char parameterLabel[24 + 1]);							///< Obtains the label of \p parameterIndex. The label should be used as a suffix when presenting the parameter value to the user. You can expect the label to stay constant during the life-time of the plug-in. The VST spec says 8 characters max, but many VSTs don't care about that, so I say 24. :-)
@@ -759,8 +1397,11 @@ class VSTPlugIn {
 	public:		void resume();																							///< Resumes the plug-in. You must call this method before performing any processing. It is illegal to call this method if the plug-in is already in resumed state. (I.e. each call to resume() should be balanced with a call to suspend().)
 	public:		void suspend();																							///< Suspends the plug-in. Calling this method allows the plug-in to release any resources necessary for processing (and if necessary update it's gui accordingly). It is illegal to call any of the processing methods when the plug-in is in suspended state. It is also illegal to call suspend more than once without a call to resume() in between. 
 	public:		bool wantsMidi();																						///< Returns true if the plug-in has flagged that it is interested in receiving MIDI data. Will issue a call to plug-ins "canDo". Should only be called when plug-ins is "resumed".
+	public:		bool sendsMidi();																						///< Returns true if the plug-in says it can send MIDI events to the host (see VSTHost::processEvents()). Will issue a call to plug-ins "canDo".
 	public:		void processAccumulating(const float* const* inBuffers, float* const* outBuffers, VstInt32 sampleCount);///< Processes samples from \p inBuffers and accumulates result in \p outBuffers. This is a legacy method for performing audio processing. processReplacing() is preferred. See processReplacing() for further documentation.
 	public:		void processEvents(const VstEvents& events);															///< Processes the VST events in \p events (typically MIDI events). The events should be sorted in time (see deltaFrames in the VstEvent struct). Call this method before processReplacing(), and never more than once. The VstEvents struct only contains room for 2 events, so you would normally need to allocate your own VstEvents struct on the heap, or alternatively use a customized "hacked" VstEvents struct with more than 2 elements. See the VstEvents and VstEvent structs in the VST SDK documentation for more info. 
+	public:		bool setProcessPrecision(bool doublePrecision);															///< Tells the plug-in whether processDoubleReplacing() (\p doublePrecision = true) or processReplacing() will be used for processing. Must be called in suspended state. Returns false if not supported.
+	public:		void processDoubleReplacing(const double* const* inBuffers, double* const* outBuffers, VstInt32 sampleCount);///< Same as processReplacing(), but with 64-bit floating-point buffers. Only call this if canProcessDoubleReplacing() returns true and setProcessPrecision(true) has been called before resume().
 	public:		void processReplacing(const float* const* inBuffers, float* const* outBuffers, VstInt32 sampleCount);	///< Processes samples from \p inBuffers and places result in \p outBuffers. \p inBuffers and \p outBuffers are arrays with pointers to floating-point buffers for the sample data. You need to allocate and setup pointers to at least getInputCount() number of input buffers and getOutputCount() number of output buffers. Each input buffer should contain \p sampleCount number of samples, and each output buffer should contain space for at least as many samples. It is legal to use the input buffers as output buffers (for "in place processing").
 	public:		VstIntPtr vendorSpecific(VstInt32 intA, VstIntPtr intB, void* pointer, float floating);					///< Perform any vendor-specific call to the plug-in. Used in Symbiosis for some AU-specific features. See Symbiosis documentation for more info.
 	public:		VstInt32 getTailSize();																					///< Returns the "tail" of the effect plug-in. The "tail" is the number of samples that will need processing after the input has turned entirely silent, for example the tail of a decaying reverb. There are two special return values that you should pay attention to. 0 is returned if tail length is variable / unknown / not supported and 1 is returned if the plug-in has no tail at all.
@@ -786,6 +1427,8 @@ class VSTPlugIn {
 	protected:	static VstIntPtr staticAudioMasterCallback(AEffect *effect, VstInt32 opcode, VstInt32 index
 						, VstIntPtr value, void *ptr, float opt);
 	protected:	VstIntPtr dispatch(VstInt32 opCode, VstInt32 index, VstIntPtr value, void *ptr, float opt);
+	protected:	float readParameter(VstInt32 parameterIndex);
+	protected:	void incrementStateGeneration();
 	protected:	unsigned char* writeFxCk(unsigned char* bp);
 	protected:	const unsigned char* readFxCk(const unsigned char* bp, const unsigned char* ep, bool* wasPerfect);
 
@@ -799,6 +1442,15 @@ class VSTPlugIn {
 	protected:	bool editorOpenFlag;
 	protected:	float currentSampleRate;
 	protected:	VstInt32 currentBlockSize;
+	protected:	float* parameterCache;																					// Last known value per parameter.
+	protected:	volatile ::uint32_t* parameterCacheStale;																// One bit per parameter, set if parameterCache may differ from the plug-in's value.
+	protected:	VstInt32 parameterCacheSweepIndex;
+	protected:	VstInt32 parameterCacheStaleWord;																		// Index in parameterCacheStale where reconcileParameterCache() continues looking for stale parameters.
+	protected:	volatile ::int32_t parameterCacheGeneration;
+	protected:	volatile ::int32_t stateGeneration;
+	protected:	VstInt32 lastKnownProgram;																				// Last program returned by getCurrentProgram() or set with setCurrentProgram().
+	protected:	volatile bool isWalkingPrograms;																		// True while createFXB() walks through the programs.
+	protected:	::pthread_t programWalkThread;																			// The thread running createFXB() while isWalkingPrograms is true.
 };
 
 /**
@@ -818,6 +1470,7 @@ class SymbiosisComponent : public VSTHost {
 	public:		virtual bool isIOPinConnected(VSTPlugIn& plugIn, bool checkOutputPin, VstInt32 pinIndex);
 	public:		virtual void updateDisplay(VSTPlugIn& plugIn);
 	public:		virtual void resizeWindow(VSTPlugIn& plugIn, VstInt32 width, VstInt32 height);
+	public:		virtual void processEvents(VSTPlugIn& plugIn, const VstEvents& events);
 
 	/// Audio Unit entry point functions
 	/// @{
@@ -872,6 +1525,7 @@ class SymbiosisComponent : public VSTHost {
 						, ::CFStringRef presetName);
 	protected:	::CFMutableDictionaryRef createAUPresetOfCurrentBank(::CFStringRef nameRef);
 	protected:	::CFMutableDictionaryRef createAUPresetOfCurrentProgram(::CFStringRef nameRef);
+	protected:	::CFMutableDictionaryRef createClassInfo();
 	protected:	void convertLoadedPrograms(const ::FSRef* parentFSRef, bool writeNameListToFile = false
 						, ::FSIORefNum nameListFork = 0);
 	protected:	void convertVSTPreset(const ::FSRef* fsRef, bool isFXB);
@@ -882,29 +1536,75 @@ class SymbiosisComponent : public VSTHost {
 	protected:	void loadFactoryPresets(::FSRef* factoryPresetsListFSRef);
 	protected:	void loadOrCreateFactoryPresets();
 	protected:	void convertVSTPresets();
+	protected:	bool isMappedParameter(int parameterIndex) const;
+	protected:	void allocateMappedParameters(int capacity);
+	protected:	void addMappedParameter(const SymbiosisParameterMapping& mapping);
+	protected:	bool getCacheFSRef(const char suffix[], ::FSRef* fsRef, bool create);
+	protected:	bool readParameterCache(size_t sourceSize, ::uint32_t sourceHash, ::CFMutableDataRef image);
+	protected:	void writeParameterCache(::CFDataRef image);
+	protected:	void compileParameterMapping(const unsigned char* bytes, size_t size, ::uint32_t hash
+						, ::CFMutableDataRef image);
+	protected:	void applyParameterMapping(::CFDataRef image);
 	protected:	void readParameterMapping(const ::FSRef* fsRef);
 #if (SY_INCLUDE_CONFIG_GEN)
-	protected:	void createDefaultParameterMappingFile(const ::FSRef* fsRef);
+	protected:	void getGeneratedParametersSuffix(char suffix[63 + 1]);
+	protected:	void createDefaultParameterMappingFile(::FSRef* fsRef);
 #endif
 	protected:	void readOrCreateParameterMapping();
+	protected:	void readMIDIMap();
 	protected:	void reallocateIOBuffers();
+	protected:	void resetFIFOs();
+	protected:	bool needsSampleConversion() const;
+	protected:	unsigned char* getConversionBuffer(int channel) const;
 	protected:	int getMaxInputChannels(int busNumber) const;
 	protected:	int getMaxOutputChannels(int busNumber) const;
 	protected:	int getActiveInputChannels(int busNumber) const;
 	protected:	int getActiveOutputChannels(int busNumber) const;
-	protected:	float scaleFromAUParameter(int parameterIndex, float auValue);
+	protected:	float scaleFromAUParameter(int parameterIndex, float auValue);											// Scales an AU parameter value to the VST 0 to 1 range according to the curve in SYParameters.txt.
 	protected:	float scaleToAUParameter(int parameterIndex, float vstValue);
 	protected:	static pascal void idleTimerAction(::EventLoopTimerRef /*theTimer*/, void* theUserData);
 	protected:	void propertyChanged(::AudioUnitPropertyID id, ::AudioUnitScope scope, ::AudioUnitElement element);
+	protected:	void notifyParameterChange(int parameterIndex);
+	protected:	void flushParameterNotification(int parameterIndex);
+	protected:	void flushParameterNotifications();
 	protected:	void updateCurrentVSTProgramName(::CFStringRef presetName);
 	protected:	bool updateCurrentAUPreset();
 	protected:	void getPropertyInfo(::AudioUnitPropertyID id, ::AudioUnitScope scope, ::AudioUnitElement element
 						, bool* isReadable, bool* isWritable, int* minDataSize, int* normalDataSize);
 	protected:	void updateVSTTimeInfo(const ::AudioTimeStamp* inTimeStamp);
-	protected:	bool collectInputAudio(int frameCount, float** inputPointers, const ::AudioTimeStamp* timeStamp);
-	protected:	void renderOutput(int frameCount, const float* const* inputPointers, float** outputPointers
-						, bool inputIsSilent);
-	protected:	void render(::AudioUnitRenderActionFlags* ioActionFlags, const ::AudioTimeStamp* inTimeStamp
+	protected:	template<typename T> ::OSStatus collectInputAudio(int frameCount, T** inputPointers
+						, const ::AudioTimeStamp* timeStamp, const ::AudioBufferList* inPlaceBuffers, bool* inputIsSilent);
+	protected:	void scheduleParameterRamp(int parameter, int startOffset, int durationFrames, float startValue
+						, float endValue);
+	protected:	void updateParameterRamps(int offset);
+	protected:	void finishParameterRamps();
+	protected:	void allocateParameterSmoothers(int capacity);
+	protected:	void releaseParameterSmoothers();
+	protected:	void allocateParameterCurves(int capacity);
+	protected:	void releaseParameterCurves();
+	protected:	void compileParameterCurve(int slot, const SymbiosisParameterMapping& mapping);
+	protected:	void scaleFromAUParameters(int count, const int* parameterIndexes, const float* auValues
+						, float* vstValues);
+	protected:	void updateParameterSmoothingRates();
+	protected:	void setParameterSmoothed(int parameter, float value);
+	protected:	void setParameterUnsmoothed(int parameter, float value);
+	protected:	void updateParameterSmoothers(int offset);
+	protected:	void finishParameterSmoothing();
+	protected:	int findSubBlockEnd(int offset, int frameCount, int midiIndex, int parameterIndex) const;
+	protected:	bool updateSilenceCountdown(int frameCount, bool inputIsSilent);
+	protected:	void offsetVSTTimeInfo(double baseSamplePos, double basePpqPos, int offset);
+	protected:	void processVST(const float* const* inputPointers, float* const* outputPointers, int frameCount);
+	protected:	void processVST(const double* const* inputPointers, double* const* outputPointers, int frameCount);
+	protected:	template<typename T> void renderOutput(int frameCount, const T* const* inputPointers, T** outputPointers
+						, bool inputIsSilent, bool isLastChunk);
+	protected:	template<typename T> void renderThroughFIFOs(int frameCount, const T* const* inputPointers
+						, T** outputPointers, bool inputIsSilent, bool isLastChunk);
+	protected:	template<typename T> ::OSStatus renderChunks(const ::AudioTimeStamp* inTimeStamp, int frameCount
+						, ::AudioBufferList* ioData, bool processInPlace);
+	protected:	void encodeOutput(int busNumber, int frameCount, ::AudioBufferList* ioData);
+	protected:	void deliverMIDIOutput(const ::AudioTimeStamp* inTimeStamp, int frameCount);
+	protected:	::OSStatus renderFailed(::OSStatus error);
+	protected:	::OSStatus render(::AudioUnitRenderActionFlags* ioActionFlags, const ::AudioTimeStamp* inTimeStamp
 						, ::UInt32 inOutputBusNumber, ::UInt32 inNumberFrames, ::AudioBufferList* ioData);
 	protected:	void getProperty(::UInt32* ioDataSize, void* outData, ::AudioUnitElement inElement
 						, ::AudioUnitScope inScope, ::AudioUnitPropertyID inID);
@@ -912,12 +1612,20 @@ class SymbiosisComponent : public VSTHost {
 	protected:	bool updateTailTime();
 	protected:	void updateInitialDelayAndTailTimes();
 	protected:	bool updateSampleRate(::Float64 newSampleRate);
+	protected:	bool updateSampleFormat(SymbiosisSampleFormat newSampleFormat, bool newIsInterleaved);
 	protected:	void updateMaxFramesPerSlice(int newFramesPerSlice);
 	protected:	void updateFormat(::AudioUnitScope scope, int busNumber, const ::AudioStreamBasicDescription& format);
 	protected:	void setProperty(::UInt32 inDataSize, const void* inData, ::AudioUnitElement inElement
 						, ::AudioUnitScope inScope, ::AudioUnitPropertyID inID);
 	protected:	void tryToIdentifyHostApplication();
+	protected:	void scheduleParameter(int offset, int parameterIndex, float value);
+	protected:	bool coalesceMIDIEvents(const VstMidiEvent& incoming);
+	protected:	void queueVSTEvent(int offset);
 	protected:	void midiInput(int offset, int status, int data1, int data2);
+	protected:	void sysExInput(int offset, const ::UInt8* data, int length);
+	protected:	void drainParameterQueue();
+	protected:	void beginStateLoad();
+	protected:	void endStateLoad();
 
 	protected:	enum HostApplication {
 					undetermined
@@ -939,33 +1647,94 @@ class SymbiosisComponent : public VSTHost {
 	protected:	::Float64 lastRenderSampleTime;
 	protected:	::AudioUnitConnection inputConnections[kMaxBuses];
 	protected:	::AURenderCallbackStruct renderCallbacks[kMaxBuses];
-	protected:	float* ioBuffers[kMaxChannels];
+	protected:	float* ioBuffers[kMaxChannels];																			// Room for maxFramesPerSlice samples in the stream format (i.e. may hold doubles), processed in the VST's precision.
+	protected:	unsigned char* conversionBuffer;																		// Raw stream samples for formats that need conversion (see needsSampleConversion()). Room for maxFramesPerSlice 64-bit samples per channel.
+	protected:	SymbiosisSampleFormat streamSampleFormat;																// Shared by all buses (just like the sample rate).
+	protected:	int streamSampleBytes;
+	protected:	bool streamIsInterleaved;
+	protected:	int vstSampleBytes;																						// 8 if the VST processes with processDoubleReplacing(), 4 otherwise. Decided in AudioUnitInitialize.
+	protected:	bool renderedIntoHostBuffers;																			// True if the VST output of the last render went directly into the host's AudioBufferList (and not into ioBuffers).
+	protected:	float* fifoInputBuffers[kMaxChannels];																	// Input collected for the next fixed size block (only used if fixedBlockSize > 0).
+	protected:	float* fifoOutputBuffers[kMaxChannels];																	// Output of the last fixed size block, played back while the next block is being collected.
+	protected:	int fifoFrames;																							// Frames collected in fifoInputBuffers (and played back from fifoOutputBuffers).
+	protected:	bool fifoInputSilent;
+	protected:	bool fifoOutputSilent;
 	protected:	bool silentOutput;
 	protected:	int propertyListenersCount;
-	protected:	AUPropertyListener propertyListeners[kMaxPropertyListeners];
+	protected:	AUPropertyListener propertyListeners[kMaxPropertyListeners];											// Kept sorted on fPropertyID (in order of addition for equal IDs).
 	protected:	::HostCallbackInfo hostCallbackInfo;
 	protected:	::AUPreset currentAUPreset;
+	protected:	bool currentVSTProgramNameValid;																		// True if currentVSTProgramName is known to match currentAUPreset.presetName.
+	protected:	char currentVSTProgramName[24 + 1];																		// VST program name last compared with (or copied to) currentAUPreset.presetName.
+	protected:	volatile ::int32_t displayUpdatePending;																// Set by updateDisplay(), the preset is checked and listeners notified from the idle timer.
 	protected:	::AUPreset factoryPresets[kMaxFactoryPresets];
 	protected:	::CFDataRef factoryPresetData[kMaxFactoryPresets];
 	protected:	::CFMutableArrayRef factoryPresetsArray;
-	protected:	int parameterCount;
-	protected:	::AudioUnitParameterID parameterList[kMaxMappedParameters];
-	protected:	::AudioUnitParameterInfo* parameterInfos;																// Index is actually VST parameter index since this is the same as the parameter id
-	protected:	::CFArrayRef* parameterValueStrings;																	// Index is actually VST parameter index since this is the same as the parameter id
+	protected:	int parameterCount;																						// Number of mapped parameters (the ones listed in SYParameters.txt).
+	protected:	int* parameterSlots;																					// Index in the per mapped parameter arrays below per parameter (VST index, which is also the AU parameter id), -1 if not mapped.
+	protected:	::AudioUnitParameterID* parameterList;																	// Per mapped parameter (in SYParameters.txt order).
+	protected:	::AudioUnitParameterInfo* parameterInfos;																// Per mapped parameter.
+	protected:	SymbiosisDisplayString* displayStrings;																	// Last display string per mapped parameter.
+	protected:	unsigned int displayStringLookups;
+	protected:	unsigned int displayStringHits;
+	protected:	::CFArrayRef* parameterValueStrings;																	// Per mapped parameter.
+	protected:	SymbiosisParameterQueue parameterQueue;																	// Parameter changes from non-render threads, applied at the top of the next render call.
+	protected:	volatile ::uint32_t* pendingParameterNotifications;														// One bit per parameter (VST index), set if a value change notification is waiting for the idle timer.
+	protected:	volatile ::int32_t* pendingParameterWrites;																// Number of queued (not yet applied) changes per mapped parameter.
+	protected:	float* pendingParameterValues;																			// Latest queued value per mapped parameter, returned by AudioUnitGetParameter until the change has been applied.
+	protected:	volatile ::int32_t renderInProgress;
+	protected:	volatile ::int32_t lastRenderError;																		// First render error since the host last read kAudioUnitProperty_LastRenderError.
+	protected:	volatile ::int32_t lastRenderErrorChanged;																// Set by the render thread, property listeners are notified from the idle timer.
+	protected:	volatile ::int32_t stateLoadsPending;																	// Non-zero while the VST program / bank is being replaced from another thread. Render outputs silence meanwhile.
 	protected:	bool presetIsFXB;
+	protected:	::CFMutableDictionaryRef classInfoSnapshot;																// Last ClassInfo created, reused until any of the values below change.
+	protected:	bool classInfoSnapshotIsFXB;
+	protected:	::CFStringRef classInfoSnapshotName;
+	protected:	::int32_t classInfoSnapshotGeneration;																	// VSTPlugIn::getStateGeneration() after classInfoSnapshot was created.
+	protected:	VstIntPtr classInfoSnapshotCounter;																		// State-change counter reported by the VST through 'sSCC' (0 if not supported).
 	protected:	bool autoConvertPresets;
 	protected:	bool updateNameOnLoad;
 	protected:	bool canDoMonoIO;
+	protected:	int subBlockMinFrames;																					// 0 = process the entire slice at once, > 0 = split at event offsets (but never into blocks shorter than this).
+	protected:	int fixedBlockSize;																						// 0 = process as many frames as the host requests, > 0 = always process this many frames (through FIFOs).
 	protected:	VSTPlugIn* vst;
-	protected:	SymbiosisVstEvents vstMidiEvents;
+	protected:	SymbiosisVstEvents vstMidiEvents;																		// Kept sorted on deltaFrames.
+	protected:	SymbiosisVstEvents vstSubBlockEvents;																	// Points into vstMidiEvents for the sub-block currently being processed.
+	protected:	unsigned char* sysExArena;																				// Holds the data of every queued SysEx event (kSysExArenaSize bytes).
+	protected:	int sysExArenaUsed;																						// Reset to 0 when no SysEx events are queued anymore.
+	protected:	int scheduledParameterCount;
+	protected:	SymbiosisParameterEvent scheduledParameters[kMaxScheduledParameterEvents];								// Kept sorted on offset.
+	protected:	int rampControlFrames;																					// Interval (in frames) between interpolated parameter updates of active ramps.
+	protected:	int midiMap[16 * 128];																					// VST parameter index per MIDI channel and controller (channel * 128 + controller), -1 if not mapped.
+	protected:	int activeRampCount;
+	protected:	SymbiosisParameterRamp* activeRamps;																	// At most one ramp per mapped parameter, unordered.
+	protected:	int* rampParameters;																					// Scratch for updateParameterRamps() (one per mapped parameter).
+	protected:	float* rampValues;																						// Scratch for updateParameterRamps() (one per mapped parameter).
+	protected:	SymbiosisParameterCurves parameterCurves;																// Per mapped parameter.
+	protected:	int* parameterSmootherIndices;																			// Index in parameterSmoothers per mapped parameter, -1 if the parameter is not smoothed.
+	protected:	SymbiosisParameterSmoothers parameterSmoothers;
+	protected:	bool smoothingActive;																					// True while any smoother may not have reached its target.
+	protected:	int lastSmoothingOffset;																				// Offset of the last smoother update relative to the current slice (negative if in an earlier slice).
 	protected:	VstTimeInfo vstTimeInfo;
 	protected:	bool vstGotSymbiosisExtensions;
 	protected:	bool vstSupportsTail;
 	protected:	double initialDelayTime;
 	protected:	double tailTime;
+	protected:	int silenceTailFrames;																					// Frames to keep processing after the input turns silent, -1 if unknown (always process).
+	protected:	int silenceCountdown;
 	protected:	bool vstSupportsBypass;
 	protected:	bool isBypassing;
+	protected:	bool vstCanProcessInPlace;																				// False if the VST has opted out of aliased input and output buffers with the 'sNIP' vendor-specific call.
+	protected:	bool inPlaceProcessing;
 	protected:	bool vstWantsMidi;
+	protected:	bool vstSendsMidi;
+	protected:	::AUMIDIOutputCallbackStruct midiOutputCallback;
+	protected:	::pthread_t renderThread;																				// Valid while renderInProgress is non-zero.
+	protected:	int renderBlockOffset;																					// Frames from the start of the render call to the first frame passed to renderOutput().
+	protected:	int vstProcessOffset;																					// Frames from the start of the render call to the first frame of the current VST process call.
+	protected:	int midiOutputEventCount;
+	protected:	SymbiosisMIDIOutputEvent midiOutputEvents[kMaxMIDIOutputEvents];										// MIDI sent by the VST during render, unsorted across carried over events. Only accessed on the render thread.
+	protected:	::Byte midiOutputPacketList[sizeof (::MIDIPacketList) + kMaxMIDIOutputEvents * 16];						// One message per packet, a packet with header, up to 3 data bytes and alignment takes at most 16 bytes.
 	protected:	int inputBusCount;
 	protected:	int outputBusCount;
 	protected:	int inputBusChannelNumbers[kMaxBuses + 1];
@@ -998,11 +1767,13 @@ public:
 VSTPlugIn* VSTPlugIn::tempPlugInPointer = 0;
 
 bool VSTPlugIn::isOpen() const { return openFlag; }
+::CFBundleRef VSTPlugIn::getBundleRef() const { return bundleRef; }
 bool VSTPlugIn::isEditorOpen() const { return editorOpenFlag; }
 bool VSTPlugIn::isResumed() const { return resumedFlag; }
 bool VSTPlugIn::hasEditor() const { SY_ASSERT(aeffect != 0); return ((aeffect->flags & effFlagsHasEditor) != 0); }
 VstInt32 VSTPlugIn::getProgramCount() const { SY_ASSERT(aeffect != 0); return aeffect->numPrograms; }
 VstInt32 VSTPlugIn::getParameterCount() const { SY_ASSERT(aeffect != 0); return aeffect->numParams; }
+VstInt32 VSTPlugIn::getVersion() const { SY_ASSERT(aeffect != 0); return aeffect->version; }
 VstInt32 VSTPlugIn::getInputCount() const { SY_ASSERT(aeffect != 0); return aeffect->numInputs; }
 VstInt32 VSTPlugIn::getOutputCount() const { SY_ASSERT(aeffect != 0); return aeffect->numOutputs; }
 VstInt32 VSTPlugIn::getInitialDelay() const { SY_ASSERT(aeffect != 0); return aeffect->initialDelay; }
@@ -1013,6 +1784,11 @@ VstIntPtr VSTPlugIn::myAudioMasterCallback(VstInt32 opcode, VstInt32 index, VstI
 	switch (opcode) {
 		case audioMasterAutomate:
 			SY_TRACE2(SY_TRACE_FREQUENT, "VST audioMasterAutomate: %d=%f", index, opt);
+			if (parameterCache != 0 && index >= 0 && index < getParameterCount()) {
+				::OSAtomicAnd32Barrier(~(1U << (index & 31)), &parameterCacheStale[index >> 5]);
+				parameterCache[index] = opt;
+			}
+			incrementStateGeneration();
 			host.automate(*this, index, opt);
 			break;
 		
@@ -1068,6 +1844,9 @@ VstIntPtr VSTPlugIn::myAudioMasterCallback(VstInt32 opcode, VstInt32 index, VstI
 
 		case audioMasterUpdateDisplay:
 			SY_TRACE(SY_TRACE_VST, "VST audioMasterUpdateDisplay");
+			if (parameterCache != 0) {
+				invalidateParameterCache();
+			}
 			host.updateDisplay(*this);
 			return 1;
 		
@@ -1081,6 +1860,14 @@ VstIntPtr VSTPlugIn::myAudioMasterCallback(VstInt32 opcode, VstInt32 index, VstI
 			host.endEdit(*this, index);
 			return 1;
 		
+		case audioMasterProcessEvents:
+			SY_TRACE(SY_TRACE_FREQUENT, "audioMasterProcessEvents");
+			if (ptr == 0) {
+				return 0;
+			}
+			host.processEvents(*this, *reinterpret_cast<const VstEvents*>(ptr));
+			return 1;
+		
 		default: SY_TRACE1(SY_TRACE_VST, "VST unknown callback opcode: %d", opcode); break;
 		case audioMasterVersion: SY_TRACE(SY_TRACE_VST, "VST audioMasterVersion"); return 2300;
 		case audioMasterIdle: SY_TRACE(SY_TRACE_VST, "VST audioMasterIdle"); host.idle(*this); return 0;
@@ -1089,7 +1876,6 @@ VstIntPtr VSTPlugIn::myAudioMasterCallback(VstInt32 opcode, VstInt32 index, VstI
 		case DECLARE_VST_DEPRECATED(audioMasterSetTime): SY_TRACE(SY_TRACE_VST, "VST audioMasterSetTime (not supported)"); break;
 		case DECLARE_VST_DEPRECATED(audioMasterTempoAt): SY_TRACE(SY_TRACE_VST, "VST audioMasterTempoAt (not supported)"); break;
 		case DECLARE_VST_DEPRECATED(audioMasterGetNumAutomatableParameters): SY_TRACE(SY_TRACE_VST, "VST audioMasterGetNumAutomatableParameters (not supported)"); break;
-		case audioMasterProcessEvents: SY_TRACE(SY_TRACE_VST, "VST audioMasterProcessEvents (not supported)"); break;
 		case audioMasterIOChanged: SY_TRACE(SY_TRACE_VST, "VST audioMasterIOChanged (not supported)"); break;
 		case audioMasterGetInputLatency: SY_TRACE(SY_TRACE_VST, "VST audioMasterGetInputLatency (not supported)"); break;
 		case audioMasterGetOutputLatency: SY_TRACE(SY_TRACE_VST, "VST audioMasterGetOutputLatency (not supported)"); break;
@@ -1146,7 +1932,10 @@ VstIntPtr VSTPlugIn::staticAudioMasterCallback(AEffect *effect, VstInt32 opcode,
 
 VSTPlugIn::VSTPlugIn(VSTHost& host, ::CFBundleRef vstBundleRef, float sampleRate, VstInt32 blockSize)
 		: host(host), bundleRef(0), aeffect(0), openFlag(false), resumedFlag(false), wantsMidiFlag(false)
-		, editorOpenFlag(false), currentSampleRate(sampleRate), currentBlockSize(blockSize)	{							// Note: some plug-ins request the sample rate and block-size during initialization (via the AudioMasterCallback), therefore we set them here to start with.
+		, editorOpenFlag(false), currentSampleRate(sampleRate), currentBlockSize(blockSize), parameterCache(0)
+		, parameterCacheStale(0), parameterCacheSweepIndex(0), parameterCacheStaleWord(0)
+		, parameterCacheGeneration(0), stateGeneration(0), lastKnownProgram(-1), isWalkingPrograms(false)
+		, programWalkThread(0) {																						// Note: some plug-ins request the sample rate and block-size during initialization (via the AudioMasterCallback), therefore we set them here to start with.
 	::CFRetain(vstBundleRef);
 	bundleRef = vstBundleRef;
 }
@@ -1156,6 +1945,15 @@ bool VSTPlugIn::canProcessReplacing() const {
 	return ((aeffect->flags & effFlagsCanReplacing) != 0);
 }
 
+bool VSTPlugIn::canProcessDoubleReplacing() const {
+	SY_ASSERT(aeffect != 0);
+#if (SY_USE_VST_VERSION >= 2400)
+	return ((aeffect->flags & effFlagsCanDoubleReplacing) != 0);
+#else
+	return false;
+#endif
+}
+
 bool VSTPlugIn::hasProgramChunks() const {
 	SY_ASSERT(aeffect != 0);
 	return ((aeffect->flags & effFlagsProgramChunks) != 0);
@@ -1217,6 +2015,11 @@ void VSTPlugIn::open() {
 	}
 	dispatch(effOpen, 0, 0, 0, 0);
 	openFlag = true;
+	SY_ASSERT(parameterCache == 0);
+	parameterCache = new float[std::max(getParameterCount(), 1)];
+	memset(parameterCache, 0, sizeof (float) * std::max(getParameterCount(), 1));
+	parameterCacheStale = new ::uint32_t[(getParameterCount() + 31) / 32 + 1];
+	invalidateParameterCache();
 }
 
 void VSTPlugIn::setSampleRate(float sampleRate) {
@@ -1239,12 +2042,20 @@ void VSTPlugIn::setCurrentProgram(VstInt32 program) {
 	SY_TRACE1(SY_TRACE_VST, "VST setCurrentProgram: %d", program);
 	SY_ASSERT(program >= 0 && program < getProgramCount());
 	dispatch(effSetProgram, 0, program, 0, 0);
+	lastKnownProgram = program;
+	invalidateParameterCache();
+	incrementStateGeneration();
 }
 
 VstInt32 VSTPlugIn::getCurrentProgram() {
 	SY_TRACE(SY_TRACE_VST, "VST getCurrentProgram");
 	VstInt32 programNumber = static_cast<VstInt32>(dispatch(effGetProgram, 0, 0, 0, 0));
-	return (programNumber > aeffect->numPrograms) ? aeffect->numPrograms : programNumber;
+	programNumber = (programNumber > aeffect->numPrograms) ? aeffect->numPrograms : programNumber;
+	if (programNumber != lastKnownProgram) {																			// E.g. changed by a MIDI program change.
+		lastKnownProgram = programNumber;
+		incrementStateGeneration();
+	}
+	return programNumber;
 }
 
 void VSTPlugIn::getCurrentProgramName(char programName[24 + 1]) {
@@ -1259,6 +2070,7 @@ void VSTPlugIn::setCurrentProgramName(const char programName[24 + 1]) {
 	SY_TRACE1(SY_TRACE_VST, "VST setCurrentProgramName: %s", programName);
 	SY_ASSERT(strlen(programName) <= 24);
 	dispatch(effSetProgramName, 0, 0, reinterpret_cast<void*>(const_cast<char*>(programName)), 0);
+	incrementStateGeneration();
 }
 
 bool VSTPlugIn::getProgramName(VstInt32 programIndex, char programName[24 + 1]) {
@@ -1275,6 +2087,21 @@ bool VSTPlugIn::getProgramName(VstInt32 programIndex, char programName[24 + 1])
 }
 
 float VSTPlugIn::getParameter(VstInt32 parameterIndex) {
+	SY_ASSERT(parameterIndex >= 0 && parameterIndex < getParameterCount());
+	const ::uint32_t mask = 1U << (parameterIndex & 31);
+	if ((parameterCacheStale[parameterIndex >> 5] & mask) == 0) {
+		return parameterCache[parameterIndex];
+	}
+	::OSAtomicAnd32Barrier(~mask, &parameterCacheStale[parameterIndex >> 5]);											// Clear before reading so that a concurrent invalidateParameterCache() marks it stale again.
+	const float value = readParameter(parameterIndex);
+	if (value != parameterCache[parameterIndex]) {
+		parameterCache[parameterIndex] = value;
+		incrementStateGeneration();
+	}
+	return value;
+}
+
+float VSTPlugIn::readParameter(VstInt32 parameterIndex) {
 	SY_TRACE1(SY_TRACE_FREQUENT, "VST getParameter: %d", parameterIndex);
 	SY_ASSERT(parameterIndex >= 0 && parameterIndex < getParameterCount());
 	SY_ASSERT(aeffect != 0);
@@ -1292,10 +2119,10 @@ float VSTPlugIn::getParameter(VstInt32 parameterIndex) {
 }
 
 void VSTPlugIn::setParameter(VstInt32 parameterIndex, float value) {
-	SY_TRACE2(SY_TRACE_FREQUENT, "VST setParameter: %d=%f", parameterIndex, value);
 	SY_ASSERT(parameterIndex >= 0 && parameterIndex < getParameterCount());
 	SY_ASSERT(value >= 0.0);
 	SY_ASSERT(value <= 1.0);
+	SY_TRACE2(SY_TRACE_FREQUENT, "VST setParameter: %d=%f", parameterIndex, value);
 	SY_ASSERT(aeffect != 0);
 	SY_ASSERT0((aeffect->setParameter != 0), "VST setParameter function pointer was null");
 	try {
@@ -1304,6 +2131,62 @@ void VSTPlugIn::setParameter(VstInt32 parameterIndex, float value) {
 	catch (...) {
 		SY_ASSERT0(0, "Caught exception in VST setParameter");
 	}
+	parameterCache[parameterIndex] = value;
+	const ::uint32_t mask = 1U << (parameterIndex & 31);
+	::OSAtomicAnd32Barrier(~mask, &parameterCacheStale[parameterIndex >> 5]);											// If the plug-in quantizes or limits the value, reconcileParameterCache() will pick it up eventually.
+	incrementStateGeneration();
+}
+
+void VSTPlugIn::invalidateParameterCache() {
+	for (int i = 0; i < (getParameterCount() + 31) / 32 + 1; ++i) {
+		parameterCacheStale[i] = ~0U;
+	}
+	::OSAtomicIncrement32Barrier(&parameterCacheGeneration);
+}
+
+::int32_t VSTPlugIn::getParameterCacheGeneration() const {
+	return parameterCacheGeneration;
+}
+
+::int32_t VSTPlugIn::getStateGeneration() const {
+	return stateGeneration;
+}
+
+/**
+	Increments stateGeneration, except when called from createFXB() walking through the programs (the program changes
+	and parameter reads of the walk are not changes of the state). Calls from other threads still count.
+*/
+void VSTPlugIn::incrementStateGeneration() {
+	if (!isWalkingPrograms || !::pthread_equal(programWalkThread, ::pthread_self())) {
+		::OSAtomicIncrement32Barrier(&stateGeneration);
+	}
+}
+
+void VSTPlugIn::reconcileParameterCache(int staleReadCount, int sweepCount) {
+	const VstInt32 parameterCount = getParameterCount();
+	const int wordCount = (parameterCount + 31) / 32;
+	for (int n = 0; n < wordCount && staleReadCount > 0; ++n) {
+		const int i = parameterCacheStaleWord;
+		const int end = std::min(i * 32 + 32, static_cast<int>(parameterCount));
+		for (int j = i * 32; j < end && parameterCacheStale[i] != 0 && staleReadCount > 0; ++j) {
+			if ((parameterCacheStale[i] & (1U << (j & 31))) != 0) {
+				getParameter(j);
+				--staleReadCount;
+			}
+		}
+		if (staleReadCount > 0) {																						// Word done, otherwise continue in it on the next call.
+			parameterCacheStaleWord = (i + 1 < wordCount ? i + 1 : 0);
+		}
+	}
+	for (int i = 0; i < std::min(sweepCount, static_cast<int>(parameterCount)); ++i) {
+		parameterCacheSweepIndex = (parameterCacheSweepIndex + 1 < parameterCount ? parameterCacheSweepIndex + 1 : 0);
+		const float value = readParameter(parameterCacheSweepIndex);
+		if (value != parameterCache[parameterCacheSweepIndex]) {														// Changed by the plug-in without audioMasterAutomate (e.g. MIDI learn or LFOs).
+			const ::uint32_t mask = 1U << (parameterCacheSweepIndex & 31);
+			::OSAtomicOr32Barrier(mask, &parameterCacheStale[parameterCacheSweepIndex >> 5]);							// Re-read through getParameter() so that a concurrent setParameter() is not overwritten.
+			getParameter(parameterCacheSweepIndex);
+		}
+	}
 }
 
 void VSTPlugIn::getParameterName(VstInt32 parameterIndex, char parameterName[24 + 1]) {									// The VST spec says 8 characters max, but many VSTs don't care about that, so I say 24. :-)
@@ -1364,6 +2247,11 @@ bool VSTPlugIn::wantsMidi() {
 	return (canDoReturn == 0 ? wantsMidiFlag : canDoReturn > 0);
 }
 
+bool VSTPlugIn::sendsMidi() {
+	return (dispatch(effCanDo, 0, 0, const_cast<char*>("sendVstMidiEvent"), 0) > 0
+			|| dispatch(effCanDo, 0, 0, const_cast<char*>("sendVstEvents"), 0) > 0);
+}
+
 void VSTPlugIn::processAccumulating(const float* const* inBuffers, float* const* outBuffers, VstInt32 sampleCount) {
 	SY_ASSERT(aeffect != 0);
 	SY_ASSERT0((aeffect->DECLARE_VST_DEPRECATED(process) != 0), "VST process function pointer was null");
@@ -1396,6 +2284,34 @@ void VSTPlugIn::processReplacing(const float* const* inBuffers, float* const* ou
 	}
 }
 
+bool VSTPlugIn::setProcessPrecision(bool doublePrecision) {
+	SY_TRACE1(SY_TRACE_VST, "VST setProcessPrecision: %s", doublePrecision ? "64" : "32");
+	SY_ASSERT(openFlag && !resumedFlag);
+#if (SY_USE_VST_VERSION >= 2400)
+	return (dispatch(effSetProcessPrecision, 0, doublePrecision ? kVstProcessPrecision64 : kVstProcessPrecision32, 0, 0)
+			!= 0);
+#else
+	return !doublePrecision;
+#endif
+}
+
+void VSTPlugIn::processDoubleReplacing(const double* const* inBuffers, double* const* outBuffers
+		, VstInt32 sampleCount) {
+	SY_ASSERT(aeffect != 0);
+	SY_ASSERT(openFlag && resumedFlag);
+	SY_ASSERT(canProcessDoubleReplacing());
+#if (SY_USE_VST_VERSION >= 2400)
+	SY_ASSERT0(aeffect->processDoubleReplacing != 0, "VST processDoubleReplacing function pointer was null");
+	try {
+		(*aeffect->processDoubleReplacing)(aeffect, const_cast<double**>(inBuffers), const_cast<double**>(outBuffers)
+				, sampleCount);
+	}
+	catch (...) {
+		SY_ASSERT0(0, "Caught exception in VST processDoubleReplacing");
+	}
+#endif
+}
+
 VstIntPtr VSTPlugIn::vendorSpecific(VstInt32 intA, VstIntPtr intB, void* pointer, float floating) {
 	return dispatch(effVendorSpecific, intA, intB, pointer, floating);
 }
@@ -1561,6 +2477,7 @@ unsigned char* VSTPlugIn::createFXB(size_t& size) {
 	SY_TRACE(SY_TRACE_VST, "VST createFXB");
 	
 	int oldProgramIndex = -1;
+	float* oldParameterCache = 0;
 	unsigned char* bytes = 0;
 	size = 0;
 	try {
@@ -1605,19 +2522,33 @@ unsigned char* VSTPlugIn::createFXB(size_t& size) {
 			bp += 128;
 			oldProgramIndex = getCurrentProgram();
 			SY_ASSERT(oldProgramIndex >= 0);
+			oldParameterCache = new float[std::max(getParameterCount(), 1)];											// Restored after the walk, so that re-reading the current program only counts real changes.
+			memcpy(oldParameterCache, parameterCache, sizeof (float) * std::max(getParameterCount(), 1));
+			programWalkThread = ::pthread_self();
+			::OSMemoryBarrier();
+			isWalkingPrograms = true;
 			for (int i = 0; i < aeffect->numPrograms; ++i) {
 				setCurrentProgram(i);
 				bp = writeFxCk(bp);
 			}
-			setCurrentProgram(oldProgramIndex);
+			memcpy(parameterCache, oldParameterCache, sizeof (float) * std::max(getParameterCount(), 1));
+			setCurrentProgram(oldProgramIndex);																			// Marks the restored cache stale.
+			isWalkingPrograms = false;
+			delete [] oldParameterCache;
+			oldParameterCache = 0;
 			oldProgramIndex = -1;
 			SY_ASSERT(static_cast<size_t>(bp - bytes) == size);
 		}
 	}
 	catch (...) {
+		if (oldParameterCache != 0) {
+			memcpy(parameterCache, oldParameterCache, sizeof (float) * std::max(getParameterCount(), 1));
+		}
 		if (oldProgramIndex >= 0) {
 			setCurrentProgram(oldProgramIndex);
 		}
+		isWalkingPrograms = false;
+		delete [] oldParameterCache;
 		delete [] bytes;
 		size = 0;
 		bytes = 0;
@@ -1677,8 +2608,11 @@ bool VSTPlugIn::loadFXPOrFXB(size_t size, const unsigned char bytes[]) {
 				if (bp + chunkSize > ep) {
 					throw EOFException("Unexpected end of file in FXP / FXB data");
 				}
-				return (dispatch(effSetChunk, 1, chunkSize, reinterpret_cast<void*>(const_cast<unsigned char*>(bp)), 0)
-						!= 0);
+				const bool wasLoaded = (dispatch(effSetChunk, 1, chunkSize
+						, reinterpret_cast<void*>(const_cast<unsigned char*>(bp)), 0) != 0);
+				invalidateParameterCache();
+				incrementStateGeneration();
+				return wasLoaded;
 			}
 
 			case 'FxBk': {		// FXB program list
@@ -1715,8 +2649,11 @@ bool VSTPlugIn::loadFXPOrFXB(size_t size, const unsigned char bytes[]) {
 				if (bp + chunkSize > ep) {
 					throw EOFException("Unexpected end of file in FXB data");
 				}
-				return (dispatch(effSetChunk, 0, chunkSize, reinterpret_cast<void*>(const_cast<unsigned char*>(bp)), 0)
-						!= 0);
+				const bool wasLoaded = (dispatch(effSetChunk, 0, chunkSize
+						, reinterpret_cast<void*>(const_cast<unsigned char*>(bp)), 0) != 0);
+				invalidateParameterCache();
+				incrementStateGeneration();
+				return wasLoaded;
 			}
 		}
 	}
@@ -1783,6 +2720,11 @@ VSTPlugIn::~VSTPlugIn() {
 		aeffect = 0; // Note: sending an effClose to a VST destroys the aeffect instance
 	}
 
+	delete [] parameterCache;
+	parameterCache = 0;
+	delete [] parameterCacheStale;
+	parameterCacheStale = 0;
+
 	SY_ASSERT(bundleRef != 0);
 	SY_ASSERT(::CFBundleIsExecutableLoaded(bundleRef));
 	releaseBundleRef(bundleRef);
@@ -1833,30 +2775,63 @@ void SymbiosisComponent::uninit() {
 	}
 	releaseCFRef((::CFTypeRef*)&factoryPresetsArray);
 	releaseCFRef((::CFTypeRef*)&currentAUPreset.presetName);
+	releaseCFRef((::CFTypeRef*)&classInfoSnapshot);
+	releaseCFRef((::CFTypeRef*)&classInfoSnapshotName);
 	
-	if (vst != 0 && vst->isOpen()) {
-		for (int i = 0; i < vst->getParameterCount(); ++i) {
+	if (parameterInfos != 0) {
+		for (int i = 0; i < parameterCount; ++i) {
 			releaseCFRef((::CFTypeRef*)&parameterInfos[i].unitName);
 			releaseCFRef((::CFTypeRef*)&parameterInfos[i].cfNameString);
 			releaseCFRef((::CFTypeRef*)&parameterValueStrings[i]);
+			releaseCFRef((::CFTypeRef*)&displayStrings[i].string);
 		}
 	}
 
+	delete [] parameterSlots;
+	parameterSlots = 0;
+	delete [] parameterList;
+	parameterList = 0;
 	delete [] parameterInfos;
 	parameterInfos = 0;
+	delete [] activeRamps;
+	activeRamps = 0;
+	delete [] rampParameters;
+	rampParameters = 0;
+	delete [] rampValues;
+	rampValues = 0;
 	delete [] parameterValueStrings;
 	parameterValueStrings = 0;
+	delete [] displayStrings;
+	displayStrings = 0;
+	delete [] pendingParameterNotifications;
+	pendingParameterNotifications = 0;
+	delete [] pendingParameterWrites;
+	pendingParameterWrites = 0;
+	delete [] pendingParameterValues;
+	pendingParameterValues = 0;
+	delete [] parameterSmootherIndices;
+	parameterSmootherIndices = 0;
+	releaseParameterSmoothers();
+	releaseParameterCurves();
 	delete vst;
 	vst = 0;
 	
 	for (int i = 0; i < kMaxVSTMIDIEvents; ++i) {
-		delete vstMidiEvents.events[i];
+		delete reinterpret_cast<SymbiosisVstEventStorage*>(vstMidiEvents.events[i]);
 		vstMidiEvents.events[i] = 0;
 	}
+	delete [] sysExArena;
+	sysExArena = 0;
 	
+	delete [] conversionBuffer;
+	conversionBuffer = 0;
 	for (int i = 0; i < kMaxChannels; ++i) {
 		delete [] ioBuffers[i];
 		ioBuffers[i] = 0;
+		delete [] fifoInputBuffers[i];
+		fifoInputBuffers[i] = 0;
+		delete [] fifoOutputBuffers[i];
+		fifoOutputBuffers[i] = 0;
 	}
 	
 	for (int i = 0; i < kMaxBuses; ++i) {
@@ -1881,6 +2856,21 @@ void SymbiosisComponent::loadConfiguration() {
 			(getValueOfKeyInDictionary(syConfigDictionaryRef, CFSTR("UpdateNameOnLoad"), ::CFBooleanGetTypeID())));
 	canDoMonoIO = ::CFBooleanGetValue(reinterpret_cast< ::CFBooleanRef >
 			(getValueOfKeyInDictionary(syConfigDictionaryRef, CFSTR("CanDoMonoIO"), ::CFBooleanGetTypeID())));
+	subBlockMinFrames = getOptionalIntInDictionary(syConfigDictionaryRef, CFSTR("SubBlockMinFrames"), 0);
+	if (subBlockMinFrames < 0) {
+		throw FormatException("SubBlockMinFrames must not be negative");
+	}
+	fixedBlockSize = getOptionalIntInDictionary(syConfigDictionaryRef, CFSTR("FixedBlockSize"), 0);
+	if (fixedBlockSize < 0) {
+		throw FormatException("FixedBlockSize must not be negative");
+	}
+	if (fixedBlockSize > 0 && subBlockMinFrames > 0) {
+		throw FormatException("FixedBlockSize cannot be combined with SubBlockMinFrames");
+	}
+	rampControlFrames = getOptionalIntInDictionary(syConfigDictionaryRef, CFSTR("RampControlFrames"), 32);
+	if (rampControlFrames <= 0) {
+		throw FormatException("RampControlFrames must be greater than 0");
+	}
 }
 
 ::CFMutableDictionaryRef SymbiosisComponent::createAUPresetWithVSTData(size_t vstDataSize, const unsigned char vstData[]
@@ -1956,6 +2946,53 @@ void SymbiosisComponent::loadConfiguration() {
 	return dictionary;
 }
 
+/**
+	Returns a new copy of the current state as an AU preset for kAudioUnitProperty_ClassInfo. Serializing the state
+	(especially banks, where createFXB() walks through every program) is expensive and hosts poll ClassInfo for
+	autosave and undo, so the last serialized state is kept in classInfoSnapshot and copied as long as the VST state
+	generation, the preset name and format and the state-change counter of the VST (if it supports the 'sSCC'
+	extension) are unchanged.
+*/
+::CFMutableDictionaryRef SymbiosisComponent::createClassInfo() {
+	vst->getCurrentProgram();																							// Increments the state generation if the plug-in changed program by itself.
+	const ::int32_t generation = vst->getStateGeneration();
+	VstIntPtr counter = (vstGotSymbiosisExtensions ? vst->vendorSpecific('sSCC', 0, 0, 0) : 0);
+	if (classInfoSnapshot != 0 && classInfoSnapshotIsFXB == presetIsFXB
+			&& classInfoSnapshotGeneration == generation && classInfoSnapshotCounter == counter
+			&& ::CFEqual(classInfoSnapshotName, currentAUPreset.presetName)) {
+		SY_TRACE(SY_TRACE_FREQUENT, "Reusing ClassInfo snapshot");
+	} else {
+		releaseCFRef((::CFTypeRef*)&classInfoSnapshot);
+		releaseCFRef((::CFTypeRef*)&classInfoSnapshotName);
+		::CFMutableDictionaryRef dictionaryRef;
+		if (presetIsFXB) {
+			dictionaryRef = createAUPresetOfCurrentBank(currentAUPreset.presetName);
+		} else {
+			dictionaryRef = createAUPresetOfCurrentProgram(currentAUPreset.presetName);
+		}
+		try {
+			::SInt32 programNumber = vst->getCurrentProgram();
+			addIntToDictionary(dictionaryRef, CFSTR("ProgramNumber"), programNumber);
+		}
+		catch (...) {
+			releaseCFRef((::CFTypeRef*)&dictionaryRef);
+			throw;
+		}
+		if (vstGotSymbiosisExtensions) {
+			counter = vst->vendorSpecific('sSCC', 0, 0, 0);
+		}
+		classInfoSnapshot = dictionaryRef;
+		classInfoSnapshotIsFXB = presetIsFXB;
+		classInfoSnapshotName = currentAUPreset.presetName;
+		::CFRetain(classInfoSnapshotName);
+		classInfoSnapshotGeneration = generation;																		// Read before serializing, changes made meanwhile invalidate the snapshot (createFXB() does not count its own program walk).
+		classInfoSnapshotCounter = counter;
+	}
+	::CFMutableDictionaryRef dictionaryRef = ::CFDictionaryCreateMutableCopy(0, 0, classInfoSnapshot);
+	throwOnNull(dictionaryRef, "Could not copy ClassInfo snapshot");
+	return dictionaryRef;
+}
+
 void SymbiosisComponent::convertLoadedPrograms(const ::FSRef* parentFSRef, bool writeNameListToFile
 		, ::FSIORefNum nameListFork) {
 	SY_ASSERT(parentFSRef != 0);
@@ -2378,22 +3415,264 @@ void SymbiosisComponent::convertVSTPresets() {
 	}
 }
 
-void SymbiosisComponent::readParameterMapping(const ::FSRef* fsRef) {
-	SY_ASSERT(fsRef != 0);
-	
+bool SymbiosisComponent::isMappedParameter(int parameterIndex) const {
+	return (parameterIndex >= 0 && parameterIndex < vst->getParameterCount() && parameterSlots[parameterIndex] >= 0);
+}
+
+/**
+	Allocates all per mapped parameter storage for up to \p capacity parameters (i.e. the number of entries in the
+	compiled parameter mapping). The only tables with one entry per VST parameter are parameterSlots, the
+	pendingParameterNotifications bits (the VST may automate unmapped parameters too) and the parameter value cache
+	inside VSTPlugIn.
+*/
+void SymbiosisComponent::allocateMappedParameters(int capacity) {
 	SY_ASSERT(parameterCount == 0);
-	unsigned char* bytes = 0;
+	SY_ASSERT(parameterList == 0);
+	parameterList = new ::AudioUnitParameterID[std::max(capacity, 1)];
+	SY_ASSERT(parameterInfos == 0);
+	parameterInfos = new ::AudioUnitParameterInfo[std::max(capacity, 1)];
+	memset(parameterInfos, 0, sizeof (::AudioUnitParameterInfo) * std::max(capacity, 1));
+	SY_ASSERT(parameterValueStrings == 0);
+	parameterValueStrings = new ::CFArrayRef[std::max(capacity, 1)];
+	memset(parameterValueStrings, 0, sizeof (::CFArrayRef) * std::max(capacity, 1));
+	SY_ASSERT(displayStrings == 0);
+	displayStrings = new SymbiosisDisplayString[std::max(capacity, 1)];
+	memset(displayStrings, 0, sizeof (SymbiosisDisplayString) * std::max(capacity, 1));
+	SY_ASSERT(activeRamps == 0);
+	activeRamps = new SymbiosisParameterRamp[std::max(capacity, 1)];
+	rampParameters = new int[std::max(capacity, 1)];
+	rampValues = new float[std::max(capacity, 1)];
+	SY_ASSERT(pendingParameterWrites == 0);
+	pendingParameterWrites = new ::int32_t[std::max(capacity, 1)];
+	memset(const_cast< ::int32_t* >(pendingParameterWrites), 0, sizeof (::int32_t) * std::max(capacity, 1));
+	SY_ASSERT(pendingParameterValues == 0);
+	pendingParameterValues = new float[std::max(capacity, 1)];
+	memset(pendingParameterValues, 0, sizeof (float) * std::max(capacity, 1));
+	SY_ASSERT(parameterSmootherIndices == 0);
+	parameterSmootherIndices = new int[std::max(capacity, 1)];
+	std::fill(parameterSmootherIndices, parameterSmootherIndices + std::max(capacity, 1), -1);
+	allocateParameterSmoothers(capacity);
+	allocateParameterCurves(capacity);
+}
+
+void SymbiosisComponent::addMappedParameter(const SymbiosisParameterMapping& mapping) {
+	SY_ASSERT(mapping.vstParameterIndex >= 0 && mapping.vstParameterIndex < vst->getParameterCount());
+	SY_ASSERT(parameterSlots[mapping.vstParameterIndex] < 0);
+	SY_ASSERT(mapping.name != 0);
+	
 	::CFArrayRef choicesArray = 0;
 	::CFStringRef choicesString = 0;
 	::AudioUnitParameterInfo info;
 	memset(&info, 0, sizeof (info));
 	try {
-		size_t size = 0;
-		bytes = loadFromFile(fsRef, size);
-		char line[2047 + 1];
-		const unsigned char* bp = bytes;
-		const unsigned char* ep = bytes + size;
-		bp = readLine(bp, ep, line, 2047);
+		strncpy(info.name, mapping.name, 51);
+		info.name[51] = '\0';
+		info.unit = mapping.unit;
+		info.flags = mapping.flags;
+		if (mapping.unitName != 0) {
+			info.unitName = ::CFStringCreateWithCString(0, mapping.unitName, kCFStringEncodingMacRoman);
+			SY_ASSERT(info.unitName != 0);
+		}
+		if (mapping.choices != 0) {
+			choicesString = ::CFStringCreateWithCString(0, mapping.choices, kCFStringEncodingMacRoman);
+			SY_ASSERT(choicesString != 0);
+			choicesArray = ::CFStringCreateArrayBySeparatingStrings(0, choicesString, CFSTR("|"));
+			SY_ASSERT(choicesArray != 0);
+			releaseCFRef((::CFTypeRef*)&choicesString);
+		}
+		info.clumpID = 0;
+		info.cfNameString = ::CFStringCreateWithCString(0, mapping.name, kCFStringEncodingMacRoman);
+		SY_ASSERT(info.cfNameString != 0);
+		info.minValue = mapping.minValue;
+		info.maxValue = mapping.maxValue;
+		info.defaultValue = mapping.defaultValue;
+		const int slot = parameterCount;
+		if (mapping.smoothingTime > 0.0f) {
+			const int smootherIndex = parameterSmoothers.count;
+			parameterSmoothers.parameters[smootherIndex] = mapping.vstParameterIndex;
+			parameterSmoothers.times[smootherIndex] = mapping.smoothingTime;
+			parameterSmoothers.isExponential[smootherIndex] = mapping.smoothingIsExponential;
+			parameterSmootherIndices[slot] = smootherIndex;
+			++parameterSmoothers.count;
+		}
+		compileParameterCurve(slot, mapping);
+		parameterList[slot] = mapping.vstParameterIndex;
+		parameterInfos[slot] = info;
+		parameterValueStrings[slot] = choicesArray;
+		parameterSlots[mapping.vstParameterIndex] = slot;
+		++parameterCount;
+	}
+	catch (...) {
+		releaseCFRef((::CFTypeRef*)&info.unitName);
+		releaseCFRef((::CFTypeRef*)&info.cfNameString);
+		releaseCFRef((::CFTypeRef*)&choicesString);
+		releaseCFRef((::CFTypeRef*)&choicesArray);
+		throw;
+	}
+}
+
+/**
+	The compiled parameter mapping (and a generated SYParameters.txt if it could not be written to the bundle) is kept
+	in the user's Caches folder (under Symbiosis) since the AU bundle itself is often not writable. The file name is
+	derived from the component type, sub-type and manufacturer, followed by \p suffix. Returns false if the file does
+	not exist and \p create is false.
+*/
+bool SymbiosisComponent::getCacheFSRef(const char suffix[], ::FSRef* fsRef, bool create) {
+	SY_ASSERT(suffix != 0);
+	SY_ASSERT(fsRef != 0);
+	
+	::FSRef folderFSRef;
+	throwOnOSError(::FSFindFolder(kUserDomain, kCachesFolderType, kCreateFolder, &folderFSRef));
+	descendOrCreateFolder(&folderFSRef, 9, "Symbiosis", &folderFSRef);
+	char name[127 + 1];
+	snprintf(name, 127 + 1, "%08X%08X%08X.%s"
+			, static_cast<unsigned int>(componentDescription->componentType)
+			, static_cast<unsigned int>(componentDescription->componentSubType)
+			, static_cast<unsigned int>(componentDescription->componentManufacturer), suffix);
+	::UniChar uniName[127 + 1];
+	const size_t nameLength = strlen(name);
+	for (size_t i = 0; i < nameLength; ++i) {
+		uniName[i] = name[i];
+	}
+	::OSErr err = ::FSMakeFSRefUnicode(&folderFSRef, nameLength, uniName, kTextEncodingUnknown, fsRef);
+	if (err == fnfErr && create) {
+		throwOnOSError(::FSCreateFileUnicode(&folderFSRef, nameLength, uniName, kFSCatInfoNone, 0, fsRef, 0));
+	} else if (err == fnfErr) {
+		return false;
+	} else {
+		throwOnOSError(err);
+	}
+	return true;
+}
+
+/**
+	Tries to load the compiled parameter mapping from the cache into \p image. Returns false if there is no cache, if
+	it is invalid or if it was not compiled from a SYParameters.txt of \p sourceSize bytes hashing to \p sourceHash (for
+	the current VST parameter count and cache version). The image is fully validated, so applyParameterMapping() cannot
+	fail on it.
+*/
+bool SymbiosisComponent::readParameterCache(size_t sourceSize, ::uint32_t sourceHash, ::CFMutableDataRef image) {
+	SY_ASSERT(image != 0);
+	
+	unsigned char* bytes = 0;
+	try {
+		::FSRef cacheFSRef;
+		if (!getCacheFSRef(kParameterCacheSuffix, &cacheFSRef, false)) {
+			return false;
+		}
+		size_t size = 0;
+		bytes = loadFromFile(&cacheFSRef, size);
+		const unsigned char* p = bytes;
+		const unsigned char* e = bytes + size;
+		int magic = 0;
+		int version = 0;
+		int cachedSourceSize = 0;
+		int cachedSourceHash = 0;
+		int vstParameterCount = 0;
+		int entryCount = 0;
+		int stringsSize = 0;
+		p = readBigInt32(p, e, &magic);
+		p = readBigInt32(p, e, &version);
+		p = readBigInt32(p, e, &cachedSourceSize);
+		p = readBigInt32(p, e, &cachedSourceHash);
+		p = readBigInt32(p, e, &vstParameterCount);
+		p = readBigInt32(p, e, &entryCount);
+		p = readBigInt32(p, e, &stringsSize);
+		SY_ASSERT(p == bytes + kParameterCacheHeaderSize);
+		if (magic != kParameterCacheMagic || version != kParameterCacheVersion
+				|| cachedSourceSize != static_cast<int>(sourceSize)
+				|| static_cast< ::uint32_t >(cachedSourceHash) != sourceHash
+				|| vstParameterCount != vst->getParameterCount()) {
+			SY_TRACE(SY_TRACE_MISC, "Parameter cache is stale");
+			delete [] bytes;
+			return false;
+		}
+		if (entryCount < 0 || entryCount > vstParameterCount || stringsSize <= 0
+				|| e - p != entryCount * kParameterCacheEntrySize + stringsSize
+				|| e[-1] != '\0') {
+			throw FormatException("Invalid parameter cache layout");
+		}
+		const char* strings = reinterpret_cast<const char*>(p + entryCount * kParameterCacheEntrySize);
+		SymbiosisParameterMapping mapping;
+		for (int i = 0; i < entryCount; ++i) {
+			p = readParameterCacheEntry(p, e, strings, stringsSize, vstParameterCount, mapping);
+		}
+		::CFDataAppendBytes(image, bytes, size);
+		delete [] bytes;
+		bytes = 0;
+	}
+	catch (const std::exception& x) {
+		SY_TRACE1(SY_TRACE_EXCEPTIONS, "Failed reading parameter cache, caught exception: %s", x.what());
+		delete [] bytes;
+		return false;
+	}
+	return true;
+}
+
+/**
+	The cache is written to a temporary file (unique to this process and call) that is then renamed over the cache.
+	rename() is atomic, so another instance starting at the same time reads either the old or the new cache, never a
+	partially written one.
+*/
+void SymbiosisComponent::writeParameterCache(::CFDataRef image) {
+	SY_ASSERT(image != 0);
+	
+	static volatile ::int32_t tempFileCounter = 0;
+	char tempExtension[31 + 1];
+	snprintf(tempExtension, 31 + 1, ".%d.%d.tmp", static_cast<int>(::getpid())
+			, static_cast<int>(::OSAtomicIncrement32Barrier(&tempFileCounter)));
+	char tempSuffix[63 + 1];
+	snprintf(tempSuffix, 63 + 1, "%s%s", kParameterCacheSuffix, tempExtension);
+	char tempPath[1023 + 1] = "";
+	try {
+		::FSRef tempFSRef;
+		if (getCacheFSRef(tempSuffix, &tempFSRef, false)) {
+			throwOnOSError(::FSDeleteObject(&tempFSRef));																// saveToFile() does not truncate.
+		}
+		getCacheFSRef(tempSuffix, &tempFSRef, true);
+		throwOnOSError(::FSRefMakePath(&tempFSRef, reinterpret_cast< ::UInt8* >(tempPath), 1023));
+		saveToFile(&tempFSRef, ::CFDataGetLength(image), ::CFDataGetBytePtr(image));
+		char cachePath[1023 + 1];
+		strcpy(cachePath, tempPath);
+		cachePath[strlen(tempPath) - strlen(tempExtension)] = '\0';
+		if (::rename(tempPath, cachePath) != 0) {
+			throw SymbiosisException("Could not rename temporary parameter cache file");
+		}
+	}
+	catch (const std::exception& x) {
+		SY_TRACE1(SY_TRACE_EXCEPTIONS, "Failed writing parameter cache, caught exception: %s", x.what());
+		if (tempPath[0] != '\0') {
+			::unlink(tempPath);
+		}
+		// No throw!
+	}
+}
+
+/**
+	Parses the SYParameters.txt text in \p bytes and appends the compiled mapping to \p image. Invalid lines are
+	ignored (and traced).
+*/
+void SymbiosisComponent::compileParameterMapping(const unsigned char* bytes, size_t size, ::uint32_t hash
+		, ::CFMutableDataRef image) {
+	SY_ASSERT(bytes != 0);
+	SY_ASSERT(image != 0);
+	
+	bool* isListed = 0;
+	::CFMutableDataRef cacheEntries = 0;
+	::CFMutableDataRef cacheStrings = 0;
+	try {
+		isListed = new bool[vst->getParameterCount()];
+		std::fill(isListed, isListed + vst->getParameterCount(), false);
+		cacheEntries = ::CFDataCreateMutable(0, 0);
+		SY_ASSERT(cacheEntries != 0);
+		cacheStrings = ::CFDataCreateMutable(0, 0);
+		SY_ASSERT(cacheStrings != 0);
+		int entryCount = 0;
+		
+		char line[2047 + 1];
+		const unsigned char* bp = bytes;
+		const unsigned char* ep = bytes + size;
+		bp = readLine(bp, ep, line, 2047);
 		int lineNumber = 2;
 		while (bp < ep) {
 			bp = readLine(bp, ep, line, 2047);
@@ -2409,9 +3688,30 @@ void SymbiosisComponent::readParameterMapping(const ::FSRef* fsRef) {
 			float auDefault = 0.0f;
 			char auUnit[255 + 1] = "";
 			char auDisplayOption[1023 + 1] = "";
-			int items = sscanf(lp, "%32s%*[\t]%255[^\t]%*[\t]%f%*[\t]%f%*[\t]%1023[^\t]%*[\t]%255[^\t]%*[\t]%f"
-					, indexAndFlags, auName, &auMin, &auMax, auDisplayOption, auUnit, &auDefault);
+			char smoothing[31 + 1] = "";
+			char curve[1023 + 1] = "";
+			int items = sscanf(lp
+					, "%32s%*[\t]%255[^\t]%*[\t]%f%*[\t]%f%*[\t]%1023[^\t]%*[\t]%255[^\t]%*[\t]%f"
+					"%*[\t]%31s%*[\t]%1023s"
+					, indexAndFlags, auName, &auMin, &auMax, auDisplayOption, auUnit, &auDefault, smoothing, curve);
 			const char* auDisplayOptionPointer = eatSpace(auDisplayOption);
+			
+			float smoothingTime = 0.0f;																					// Optional column, time in ms with 'e' suffix for exponential curve ('l' for linear is optional).
+			bool smoothingIsExponential = false;
+			bool smoothingIsValid = true;
+			if (items >= 8 && strcmp(smoothing, "-") != 0) {
+				char* e;
+				smoothingTime = strtof(smoothing, &e) * 0.001f;
+				smoothingIsExponential = ((*e) == 'e');
+				smoothingIsValid = (smoothingTime > 0.0f
+						&& ((*e) == '\0' || (((*e) == 'e' || (*e) == 'l') && e[1] == '\0')));
+			}
+
+			const char* curvePointer = (items == 9 && strcmp(curve, "-") != 0 ? curve : 0);								// Optional column, see parseParameterCurve().
+			float curveSteepness;
+			bool curveIsPower;
+			float curveTable[kMaxCurveTableSize];
+			int curveTableSize;
 
 			bool isMeta = false;
 			int vstParameterIndex = 0;
@@ -2425,7 +3725,12 @@ void SymbiosisComponent::readParameterMapping(const ::FSRef* fsRef) {
 			}
 			
 			bool isValid = true;
-			if (items != 7) {
+			if (items < 7 || items > 9) {
+				isValid = false;
+			} else if (!smoothingIsValid) {
+				isValid = false;
+			} else if (curvePointer != 0 && !parseParameterCurve(curvePointer, auMin, auMax, curveSteepness
+					, curveIsPower, curveTable, curveTableSize)) {
 				isValid = false;
 			} else if (!(vstParameterIndex >= 0 && vstParameterIndex < vst->getParameterCount())) {
 				isValid = false;
@@ -2433,7 +3738,7 @@ void SymbiosisComponent::readParameterMapping(const ::FSRef* fsRef) {
 				isValid = false;
 			} else if (auDefault < auMin || auDefault > auMax) {
 				isValid = false;
-			} else if (parameterInfos[vstParameterIndex].name[0] != '\0') {												// Already exists?
+			} else if (isListed[vstParameterIndex]) {
 				isValid = false;
 			} else if (auDisplayOptionPointer[0] == '\0') {
 				isValid = false;
@@ -2442,78 +3747,143 @@ void SymbiosisComponent::readParameterMapping(const ::FSRef* fsRef) {
 			if (!isValid) {
 				SY_TRACE2(SY_TRACE_MISC, "Ignored invalid parameter-mapping line (%d): %s", lineNumber, line);
 			} else {
-				strncpy(info.name, auName, 51);
-				info.name[51] = '\0';
-				info.unitName = 0;
-				info.unit = kAudioUnitParameterUnit_Generic;
-				info.flags = kAudioUnitParameterFlag_HasCFNameString | kAudioUnitParameterFlag_IsReadable
+				SymbiosisParameterMapping mapping;
+				memset(&mapping, 0, sizeof (mapping));
+				mapping.vstParameterIndex = vstParameterIndex;
+				mapping.name = auName;
+				mapping.unit = kAudioUnitParameterUnit_Generic;
+				mapping.flags = kAudioUnitParameterFlag_HasCFNameString | kAudioUnitParameterFlag_IsReadable
 							| kAudioUnitParameterFlag_IsWritable;
 				if (auUnit[0] != '\0' && strcmp(auUnit, "-") != 0) {
-					info.unitName = ::CFStringCreateWithCString(0, auUnit, kCFStringEncodingMacRoman);
-					SY_ASSERT(info.unitName != 0);
-					info.unit = kAudioUnitParameterUnit_CustomUnit;
+					mapping.unitName = auUnit;
+					mapping.unit = kAudioUnitParameterUnit_CustomUnit;
 				}
 				if (strcmp(auDisplayOptionPointer, "=") == 0) {
 					;
 				} else if (strcmp(auDisplayOptionPointer, "?") == 0) {
-					info.flags |= kAudioUnitParameterFlag_ValuesHaveStrings;
+					mapping.flags |= kAudioUnitParameterFlag_ValuesHaveStrings;
 				} else if (strcmp(auDisplayOptionPointer, "b") == 0) {
 					SY_ASSERT2(auMin == 0, "Error in SYParameters.txt: "
 							"min parameter for 'b' display type is %f, must be 0 (parameter: %s)", auMin, auName);
 					SY_ASSERT2(auMax == 1, "Error in SYParameters.txt: "
 							"max parameter for 'b' display type is %f, must be 1 (parameter: %s)", auMax, auName);
-					info.unit = kAudioUnitParameterUnit_Boolean;
+					mapping.unit = kAudioUnitParameterUnit_Boolean;
 				} else if (strcmp(auDisplayOptionPointer, "i") == 0) {
-					info.unit = kAudioUnitParameterUnit_Indexed;
-					info.flags |= kAudioUnitParameterFlag_ValuesHaveStrings;
+					mapping.unit = kAudioUnitParameterUnit_Indexed;
+					mapping.flags |= kAudioUnitParameterFlag_ValuesHaveStrings;
 				} else {
-					SY_ASSERT(choicesString == 0);
-					choicesString = ::CFStringCreateWithCString(0, auDisplayOptionPointer, kCFStringEncodingMacRoman);
-					SY_ASSERT(choicesString != 0);
-					SY_ASSERT(choicesArray == 0);
-					choicesArray = ::CFStringCreateArrayBySeparatingStrings(0, choicesString, CFSTR("|"));
-					SY_ASSERT(choicesArray != 0);
-					releaseCFRef((::CFTypeRef*)&choicesString);
+					mapping.choices = auDisplayOptionPointer;
 					SY_ASSERT2(auMin == 0, "Error in SYParameters.txt: "
 							"min parameter for '|' display type is %f, must be 0 (parameter: %s)", auMin, auName);
-					float expectedMax = static_cast<float>(::CFArrayGetCount(choicesArray) - 1);
+					float expectedMax = static_cast<float>(std::count(auDisplayOptionPointer
+							, auDisplayOptionPointer + strlen(auDisplayOptionPointer), '|'));
 					(void)expectedMax;
-					SY_ASSERT(expectedMax >= 0);
 					SY_ASSERT3(auMax == expectedMax, "Error in SYParameters.txt: "
 							"max parameter for '|' display type is %f, should be %.0f (parameter: %s)"
 							, auMax, expectedMax, auName);
-					info.unit = kAudioUnitParameterUnit_Indexed;
+					mapping.unit = kAudioUnitParameterUnit_Indexed;
 				}
-				info.clumpID = 0;
-				info.cfNameString = ::CFStringCreateWithCString(0, auName, kCFStringEncodingMacRoman);
-				SY_ASSERT(info.cfNameString != 0);
-				info.minValue = auMin;
-				info.maxValue = auMax;
-				info.defaultValue = auDefault;
+				mapping.minValue = auMin;
+				mapping.maxValue = auMax;
+				mapping.defaultValue = auDefault;
 				if (isMeta) {
-					info.flags |= kAudioUnitParameterFlag_IsGlobalMeta;
+					mapping.flags |= kAudioUnitParameterFlag_IsGlobalMeta;
 				}
-				if (parameterCount >= kMaxMappedParameters) {
-					throw SymbiosisException("Too many mapped parameters");
+				mapping.smoothingTime = smoothingTime;
+				mapping.smoothingIsExponential = smoothingIsExponential;
+				mapping.curve = curvePointer;
+				if (curvePointer != 0 && strcmp(curvePointer, "log") == 0) {
+					mapping.flags |= kAudioUnitParameterFlag_DisplayLogarithmic;
 				}
-				parameterList[parameterCount] = vstParameterIndex;
-				++parameterCount;
-				parameterInfos[vstParameterIndex] = info;
-				memset(&info, 0, sizeof (info));
-				parameterValueStrings[vstParameterIndex] = choicesArray;
-				choicesArray = 0;
+				appendParameterCacheEntry(cacheEntries, cacheStrings, mapping);
+				isListed[vstParameterIndex] = true;
+				++entryCount;
 			}
 			++lineNumber;
 		}
+		SY_TRACE1(SY_TRACE_MISC, "Successfully parsed %d parameter-mapping lines", entryCount);
+		
+		unsigned char header[kParameterCacheHeaderSize];
+		unsigned char* p = header;
+		p = writeBigInt32(p, kParameterCacheMagic);
+		p = writeBigInt32(p, kParameterCacheVersion);
+		p = writeBigInt32(p, static_cast<int>(size));
+		p = writeBigInt32(p, static_cast<int>(hash));
+		p = writeBigInt32(p, vst->getParameterCount());
+		p = writeBigInt32(p, entryCount);
+		p = writeBigInt32(p, static_cast<int>(::CFDataGetLength(cacheStrings)));
+		SY_ASSERT(p == header + kParameterCacheHeaderSize);
+		::CFDataAppendBytes(image, header, kParameterCacheHeaderSize);
+		::CFDataAppendBytes(image, ::CFDataGetBytePtr(cacheEntries), ::CFDataGetLength(cacheEntries));
+		::CFDataAppendBytes(image, ::CFDataGetBytePtr(cacheStrings), ::CFDataGetLength(cacheStrings));
+		releaseCFRef((::CFTypeRef*)&cacheEntries);
+		releaseCFRef((::CFTypeRef*)&cacheStrings);
+		delete [] isListed;
+		isListed = 0;
+	}
+	catch (...) {
+		releaseCFRef((::CFTypeRef*)&cacheEntries);
+		releaseCFRef((::CFTypeRef*)&cacheStrings);
+		delete [] isListed;
+		isListed = 0;
+		throw;
+	}
+}
+
+/**
+	Allocates the mapped parameter storage and adds every parameter of the compiled mapping \p image (which must have
+	been validated or just compiled).
+*/
+void SymbiosisComponent::applyParameterMapping(::CFDataRef image) {
+	SY_ASSERT(image != 0);
+	
+	const unsigned char* p = ::CFDataGetBytePtr(image);
+	const unsigned char* e = p + ::CFDataGetLength(image);
+	int entryCount = 0;
+	int stringsSize = 0;
+	readBigInt32(p + 5 * 4, e, &entryCount);																			// Header fields 5 and 6 (see the layout description above appendParameterCacheString()).
+	readBigInt32(p + 6 * 4, e, &stringsSize);
+	p += kParameterCacheHeaderSize;
+	const char* strings = reinterpret_cast<const char*>(p + entryCount * kParameterCacheEntrySize);
+	allocateMappedParameters(entryCount);
+	SymbiosisParameterMapping mapping;
+	for (int i = 0; i < entryCount; ++i) {
+		p = readParameterCacheEntry(p, e, strings, stringsSize, vst->getParameterCount(), mapping);
+		if (parameterSlots[mapping.vstParameterIndex] < 0) {
+			addMappedParameter(mapping);
+		}
+	}
+}
+
+/**
+	Reads SYParameters.txt. The parsed mapping is compiled into a binary cache image (see readParameterCache()) that is
+	used instead of parsing the text as long as SYParameters.txt does not change.
+*/
+void SymbiosisComponent::readParameterMapping(const ::FSRef* fsRef) {
+	SY_ASSERT(fsRef != 0);
+	
+	SY_ASSERT(parameterCount == 0);
+	unsigned char* bytes = 0;
+	::CFMutableDataRef image = 0;
+	try {
+		size_t size = 0;
+		bytes = loadFromFile(fsRef, size);
+		const ::uint32_t hash = hashBytes(bytes, size);
+		image = ::CFDataCreateMutable(0, 0);
+		SY_ASSERT(image != 0);
+		if (readParameterCache(size, hash, image)) {
+			SY_TRACE(SY_TRACE_MISC, "Using compiled parameter mapping from parameter cache");
+		} else {
+			compileParameterMapping(bytes, size, hash, image);
+			writeParameterCache(image);
+		}
 		delete [] bytes;
 		bytes = 0;
-		SY_TRACE1(SY_TRACE_MISC, "Successfully parsed %d parameter-mapping lines", parameterCount);
+		applyParameterMapping(image);
+		releaseCFRef((::CFTypeRef*)&image);
 	}
 	catch (...) {
-		releaseCFRef((::CFTypeRef*)&info.unitName);
-		releaseCFRef((::CFTypeRef*)&info.cfNameString);
-		releaseCFRef((::CFTypeRef*)&choicesString);
-		releaseCFRef((::CFTypeRef*)&choicesArray);
+		releaseCFRef((::CFTypeRef*)&image);
 		delete [] bytes;
 		bytes = 0;
 		throw;
@@ -2522,53 +3892,104 @@ void SymbiosisComponent::readParameterMapping(const ::FSRef* fsRef) {
 
 #if (SY_INCLUDE_CONFIG_GEN)
 
-void SymbiosisComponent::createDefaultParameterMappingFile(const ::FSRef* fsRef) {
+/**
+	The name of a generated SYParameters.txt in the Caches folder includes the VST version and parameter count so that
+	it is regenerated when the VST is updated.
+*/
+void SymbiosisComponent::getGeneratedParametersSuffix(char suffix[63 + 1]) {
+	snprintf(suffix, 63 + 1, kGeneratedParametersSuffixFormat, static_cast<unsigned int>(vst->getVersion())
+			, static_cast<int>(vst->getParameterCount()));
+}
+
+/**
+	Host for the throwaway VST instance probed by createDefaultParameterMappingFile(). All callbacks are ignored (in
+	particular automation, which must not reach the AU).
+*/
+class SymbiosisProbeHost : public VSTHost {
+	public:		virtual void getVendor(VSTPlugIn& plugIn, char vendor[63 + 1]) {
+					strcpy(vendor, kSymbiosisVSTVendorString);
+				}
+	public:		virtual void getProduct(VSTPlugIn& plugIn, char product[63 + 1]) {
+					strcpy(product, kSymbiosisVSTProductString);
+				}
+	public:		virtual VstInt32 getVersion(VSTPlugIn& plugIn) { return kSymbiosisVSTVersion; }
+	public:		virtual bool canDo(VSTPlugIn& plugIn, const char string[]) { return false; }
+	public:		virtual VstTimeInfo* getTimeInfo(VSTPlugIn& plugIn, VstInt32 flags) { return 0; }
+	public:		virtual void beginEdit(VSTPlugIn& plugIn, VstInt32 parameterIndex) { }
+	public:		virtual void automate(VSTPlugIn& plugIn, VstInt32 parameterIndex, float value) { }
+	public:		virtual void endEdit(VSTPlugIn& plugIn, VstInt32 parameterIndex) { }
+	public:		virtual bool isIOPinConnected(VSTPlugIn& plugIn, bool checkOutputPin, VstInt32 pinIndex) { return true; }
+	public:		virtual void idle(VSTPlugIn& plugIn) { }
+	public:		virtual void updateDisplay(VSTPlugIn& plugIn) { }
+	public:		virtual void resizeWindow(VSTPlugIn& plugIn, VstInt32 width, VstInt32 height) { }
+	public:		virtual void processEvents(VSTPlugIn& plugIn, const VstEvents& events) { }
+};
+
+/**
+	Generates a default SYParameters.txt by probing the displays of every VST parameter. The probing is performed on a
+	separate (throwaway) instance of the VST so the state of the live instance is never touched. Instead of setting and
+	restoring one parameter at a time, the probe instance is swept in three passes: all parameters to 0, all displays
+	read, then 0.5 and then 1. The file is written to the AU bundle if possible and otherwise to the Caches folder (see
+	getCacheFSRef()). \p fsRef is set to the written file. Since the file is then read by readParameterMapping() like
+	any SYParameters.txt, its compiled mapping is cached for subsequent launches.
+*/
+void SymbiosisComponent::createDefaultParameterMappingFile(::FSRef* fsRef) {
 	SY_ASSERT(fsRef != 0);
 	
-	::FSIORefNum fileFork = 0;
-	bool isForkOpen = false;
+	const int count = vst->getParameterCount();
+	SymbiosisProbeHost probeHost;
+	VSTPlugIn* probe = 0;
+	float* defaultValues = 0;
+	char (*displays)[4][24 + 1] = 0;																					// Displays of the default value and at 0, 0.5 and 1.
+	char (*names)[2][24 + 1] = 0;
+	::CFMutableDataRef text = 0;
 	try {
-		::HFSUniStr255 dataForkName;
-		throwOnOSError(::FSGetDataForkName(&dataForkName));
-		throwOnOSError(::FSOpenFork(fsRef, dataForkName.length, dataForkName.unicode, fsWrPerm, &fileFork));
-		isForkOpen = true;
+		probe = new VSTPlugIn(probeHost, vst->getBundleRef(), static_cast<float>(streamFormat.mSampleRate)
+				, (fixedBlockSize > 0 ? fixedBlockSize : maxFramesPerSlice));
+		probe->open();
+		if (probe->getParameterCount() != count) {
+			throw SymbiosisException("VST probe instance has a different parameter count");
+		}
+		defaultValues = new float[count];
+		displays = new char[count][4][24 + 1];
+		names = new char[count][2][24 + 1];
+		for (int i = 0; i < count; ++i) {
+			vst->getParameterName(i, names[i][0]);
+			vst->getParameterLabel(i, names[i][1]);
+			defaultValues[i] = probe->getParameter(i);
+			probe->getParameterDisplay(i, displays[i][0]);
+		}
+		static const float kProbeValues[3] = { 0.0f, 0.5f, 1.0f };
+		for (int j = 0; j < 3; ++j) {
+			for (int i = 0; i < count; ++i) {
+				probe->setParameter(i, kProbeValues[j]);
+			}
+			for (int i = 0; i < count; ++i) {
+				probe->getParameterDisplay(i, displays[i][1 + j]);
+			}
+		}
+		delete probe;
+		probe = 0;
+		
+		text = ::CFDataCreateMutable(0, 0);
+		SY_ASSERT(text != 0);
 		char line[2047 + 1];
 		snprintf(line, 2047 + 1, "vst param #\tname\tmin\tmax\tdisplay\tunit\tdefault\r");
-		::ByteCount actualCount;
-		throwOnOSError(::FSWriteFork(fileFork, fsAtMark, 0, strlen(line), line, &actualCount));
-		SY_ASSERT(actualCount == strlen(line));
-		
-		for (int i = 0; i < vst->getParameterCount(); ++i) {
-			char parameterName[24 + 1];
-			vst->getParameterName(i, parameterName);
-			char parameterLabel[24 + 1];
-			vst->getParameterLabel(i, parameterLabel);
-			
-			float currentValue = vst->getParameter(i);
-			char displayDefault[24 + 1];
-			vst->getParameterDisplay(i, displayDefault);
-
-			vst->setParameter(i, 0);
-			char displayLow[24 + 1];
-			vst->getParameterDisplay(i, displayLow);
-
-			vst->setParameter(i, 0.5f);
-			char displayMid[24 + 1];
-			vst->getParameterDisplay(i, displayMid);
-
-			vst->setParameter(i, 1);
-			char displayHigh[24 + 1];
-			vst->getParameterDisplay(i, displayHigh);
-			
-			vst->setParameter(i, currentValue);
+		::CFDataAppendBytes(text, reinterpret_cast<const ::UInt8*>(line), strlen(line));
+		for (int i = 0; i < count; ++i) {
+			const float currentValue = defaultValues[i];
+			const char* displayDefault = displays[i][0];
+			const char* displayLow = displays[i][1];
+			const char* displayMid = displays[i][2];
+			const char* displayHigh = displays[i][3];
 			char* e;
 			float lowValue = 0.0f;
 			float defaultValue = currentValue;
 			float highValue = 1.0f;
 			float avgValue;
 			float midValue;
-			const char* eatenParameterName = eatSpace(parameterName);
-			const char* eatenParameterLabel = eatSpace(parameterLabel);
+			const char* eatenParameterName = eatSpace(names[i][0]);
+			const char* eatenParameterLabel = eatSpace(names[i][1]);
 			if (eatenParameterName[0] == '\0') {
 				eatenParameterName = "-";
 			}
@@ -2593,19 +4014,39 @@ void SymbiosisComponent::createDefaultParameterMappingFile(const ::FSRef* fsRef)
 			}
 			snprintf(line, 2047 + 1, "%d\t%s\t%g\t%g\t%c\t%s\t%g\r", i, eatenParameterName, lowValue, highValue
 					, displayChar, eatenParameterLabel, defaultValue);
-			throwOnOSError(::FSWriteFork(fileFork, fsAtMark, 0, strlen(line), line, &actualCount));
-			SY_ASSERT(actualCount == strlen(line));
+			::CFDataAppendBytes(text, reinterpret_cast<const ::UInt8*>(line), strlen(line));
 		}
-		::OSErr err = ::FSCloseFork(fileFork);
-		SY_ASSERT(err == noErr);
-		isForkOpen = false;
+		delete [] names;
+		names = 0;
+		delete [] displays;
+		displays = 0;
+		delete [] defaultValues;
+		defaultValues = 0;
+		
+		try {
+			throwOnOSError(::FSCreateFileUnicode(&resourcesFSRef, kParametersFileNameChars, kParametersFileName
+					, kFSCatInfoNone, 0, fsRef, 0));
+		}
+		catch (const std::exception& x) {
+			SY_TRACE1(SY_TRACE_EXCEPTIONS, "Could not create SYParameters.txt in AU bundle, caught exception: %s"
+					, x.what());
+			char suffix[63 + 1];
+			getGeneratedParametersSuffix(suffix);
+			getCacheFSRef(suffix, fsRef, true);
+		}
+		saveToFile(fsRef, ::CFDataGetLength(text), ::CFDataGetBytePtr(text));
+		releaseCFRef((::CFTypeRef*)&text);
 	}
 	catch (...) {
-		if (isForkOpen) {
-			::OSErr err = ::FSCloseFork(fileFork);
-			SY_ASSERT(err == noErr);
-			isForkOpen = false;
-		}
+		delete probe;
+		probe = 0;
+		releaseCFRef((::CFTypeRef*)&text);
+		delete [] names;
+		names = 0;
+		delete [] displays;
+		displays = 0;
+		delete [] defaultValues;
+		defaultValues = 0;
 		throw;
 	}
 }
@@ -2618,32 +4059,150 @@ void SymbiosisComponent::readOrCreateParameterMapping() {
 			, kTextEncodingUnknown, &parametersFSRef);
 #if (SY_INCLUDE_CONFIG_GEN)
 	if (err == fnfErr) {
-		throwOnOSError(::FSCreateFileUnicode(&resourcesFSRef, kParametersFileNameChars, kParametersFileName
-				, kFSCatInfoNone, 0, &parametersFSRef, 0));
-		createDefaultParameterMappingFile(&parametersFSRef);
-		err = ::FSMakeFSRefUnicode(&resourcesFSRef, kParametersFileNameChars, kParametersFileName, kTextEncodingUnknown
-				, &parametersFSRef);
+		char suffix[63 + 1];
+		getGeneratedParametersSuffix(suffix);
+		if (getCacheFSRef(suffix, &parametersFSRef, false)) {
+			SY_TRACE(SY_TRACE_MISC, "Using generated SYParameters.txt from Caches folder");
+		} else {
+			createDefaultParameterMappingFile(&parametersFSRef);
+		}
+		err = noErr;
 	}
 #endif
 	throwOnOSError(err);
 	readParameterMapping(&parametersFSRef);
 }
 
+/**
+	Reads the optional MIDI controller map (SYMIDIMap.txt) into midiMap. Each line (after the header line) is
+	"controller<tab>channel<tab>vst param #", where channel is 1 to 16 or * for all channels. Only parameters that are
+	present in SYParameters.txt can be mapped.
+*/
+void SymbiosisComponent::readMIDIMap() {
+	::FSRef midiMapFSRef;
+	::OSErr err = ::FSMakeFSRefUnicode(&resourcesFSRef, kMIDIMapFileNameChars, kMIDIMapFileName, kTextEncodingUnknown
+			, &midiMapFSRef);
+	if (err == fnfErr) {
+		return;
+	}
+	throwOnOSError(err);
+	unsigned char* bytes = 0;
+	try {
+		size_t size = 0;
+		bytes = loadFromFile(&midiMapFSRef, size);
+		char line[2047 + 1];
+		const unsigned char* bp = bytes;
+		const unsigned char* ep = bytes + size;
+		bp = readLine(bp, ep, line, 2047);
+		int lineNumber = 2;
+		int mappingCount = 0;
+		while (bp < ep) {
+			bp = readLine(bp, ep, line, 2047);
+			const char* lp = eatSpace(line);
+			if ((*lp) == '\0' || (*lp) == ';') {
+				++lineNumber;
+				continue;
+			}
+			int controller = -1;
+			char channel[32 + 1] = "";
+			int vstParameterIndex = -1;
+			int items = sscanf(lp, "%d%*[\t]%32[^\t]%*[\t]%d", &controller, channel, &vstParameterIndex);
+			const int channelNumber = (strcmp(channel, "*") == 0 ? 0 : atoi(channel));
+			if (items != 3 || controller < 0 || controller >= 128 || channelNumber < 0 || channelNumber > 16
+					|| vstParameterIndex < 0 || vstParameterIndex >= vst->getParameterCount()
+					|| parameterSlots[vstParameterIndex] < 0) {
+				SY_TRACE2(SY_TRACE_MISC, "Ignored invalid MIDI map line (%d): %s", lineNumber, line);
+			} else {
+				for (int i = (channelNumber == 0 ? 0 : channelNumber - 1); i < (channelNumber == 0 ? 16 : channelNumber)
+						; ++i) {
+					midiMap[i * 128 + controller] = vstParameterIndex;
+				}
+				++mappingCount;
+			}
+			++lineNumber;
+		}
+		delete [] bytes;
+		bytes = 0;
+		SY_TRACE1(SY_TRACE_MISC, "Successfully parsed %d MIDI map lines", mappingCount);
+	}
+	catch (...) {
+		delete [] bytes;
+		bytes = 0;
+		throw;
+	}
+}
+
 void SymbiosisComponent::reallocateIOBuffers() {
 	int ioCount = vst->getInputCount();
 	int outputCount = vst->getOutputCount();
 	if (ioCount < outputCount) {
 		ioCount = outputCount;
 	}
+	const int floatsPerSample = (streamSampleFormat == kFloat64Samples ? 2 : 1);										// The VST may process doubles only with 64-bit float streams.
 	for (int i = 0; i < kMaxChannels; ++i) {
 		delete [] ioBuffers[i];
 		ioBuffers[i] = 0;
 	}
+	delete [] conversionBuffer;
+	conversionBuffer = 0;
 	for (int i = 0; i < ioCount; ++i) {
-		ioBuffers[i] = new float[maxFramesPerSlice];
+		ioBuffers[i] = new float[maxFramesPerSlice * floatsPerSample];
+	}
+	if (streamIsInterleaved || streamSampleFormat != kFloat32Samples) {
+		conversionBuffer = new unsigned char[ioCount * maxFramesPerSlice * sizeof (double)];
+	}
+	if (fixedBlockSize > 0) {
+		for (int i = 0; i < kMaxChannels; ++i) {
+			delete [] fifoInputBuffers[i];
+			fifoInputBuffers[i] = 0;
+			delete [] fifoOutputBuffers[i];
+			fifoOutputBuffers[i] = 0;
+		}
+		for (int i = 0; i < vst->getInputCount(); ++i) {
+			fifoInputBuffers[i] = new float[fixedBlockSize * floatsPerSample];
+		}
+		for (int i = 0; i < vst->getOutputCount(); ++i) {
+			fifoOutputBuffers[i] = new float[fixedBlockSize * floatsPerSample];
+		}
+		resetFIFOs();
 	}
 }
 
+/**
+	Clears the fixed block size FIFOs. The output FIFO starts out with fixedBlockSize frames of silence, which is the
+	latency added by this mode.
+*/
+void SymbiosisComponent::resetFIFOs() {
+	for (int i = 0; i < vst->getInputCount() && fifoInputBuffers[i] != 0; ++i) {
+		memset(fifoInputBuffers[i], 0, (streamSampleFormat == kFloat64Samples ? 8 : 4) * fixedBlockSize);
+	}
+	for (int i = 0; i < vst->getOutputCount() && fifoOutputBuffers[i] != 0; ++i) {
+		memset(fifoOutputBuffers[i], 0, (streamSampleFormat == kFloat64Samples ? 8 : 4) * fixedBlockSize);
+	}
+	fifoFrames = 0;
+	fifoInputSilent = true;
+	fifoOutputSilent = true;
+}
+
+/**
+	Returns true unless the stream format is non-interleaved floats of the same precision as the VST processes, in which
+	case the host's buffers can be passed straight to the VST.
+*/
+bool SymbiosisComponent::needsSampleConversion() const {
+	return (streamIsInterleaved || streamSampleFormat != (vstSampleBytes == sizeof (double)
+			? kFloat64Samples : kFloat32Samples));
+}
+
+/**
+	Returns the raw stream samples for \p channel. For interleaved streams the buffer of a bus starts at the buffer of
+	its first channel.
+*/
+unsigned char* SymbiosisComponent::getConversionBuffer(int channel) const {
+	SY_ASSERT(conversionBuffer != 0);
+	SY_ASSERT(0 <= channel && channel < kMaxChannels);
+	return conversionBuffer + channel * maxFramesPerSlice * streamSampleBytes;
+}
+
 int SymbiosisComponent::getMaxInputChannels(int busNumber) const {
 	SY_ASSERT(0 <= busNumber && busNumber < kMaxBuses);
 	int count = inputBusChannelNumbers[busNumber + 1] - inputBusChannelNumbers[busNumber];
@@ -2711,11 +4270,25 @@ void SymbiosisComponent::tryToIdentifyHostApplication() {
 SymbiosisComponent::SymbiosisComponent(::AudioUnit auComponentInstance, const ::AudioComponentDescription *description, const std::string &componentName)
 		: auComponentInstance(auComponentInstance), componentDescription(description), componentName(componentName)
 		, auBundleRef(0), maxFramesPerSlice(kDefaultMaxFramesPerSlice)
-		, renderNotificationReceiversCount(0), lastRenderSampleTime(-12345678), silentOutput(false)
-		, propertyListenersCount(0), factoryPresetsArray(0), parameterCount(0), parameterInfos(0)
-		, parameterValueStrings(0), presetIsFXB(false), autoConvertPresets(false), updateNameOnLoad(false)
-		, canDoMonoIO(false), vst(0), vstGotSymbiosisExtensions(false), vstSupportsTail(false), initialDelayTime(0.0)
-		, tailTime(0.0), vstSupportsBypass(false), isBypassing(false), vstWantsMidi(false)
+		, renderNotificationReceiversCount(0), lastRenderSampleTime(-12345678)
+		, conversionBuffer(0), streamSampleFormat(kFloat32Samples), streamSampleBytes(sizeof (float))
+		, streamIsInterleaved(false), vstSampleBytes(sizeof (float)), renderedIntoHostBuffers(false), fifoFrames(0)
+		, fifoInputSilent(true), fifoOutputSilent(true), silentOutput(false)
+		, propertyListenersCount(0), factoryPresetsArray(0), parameterCount(0), parameterSlots(0), parameterList(0)
+		, parameterInfos(0)
+		, displayStrings(0), displayStringLookups(0), displayStringHits(0)
+		, parameterValueStrings(0), pendingParameterNotifications(0), pendingParameterWrites(0), pendingParameterValues(0)
+		, activeRamps(0), rampParameters(0), rampValues(0), parameterSmootherIndices(0)
+		, smoothingActive(false), lastSmoothingOffset(0), renderInProgress(0)
+		, currentVSTProgramNameValid(false), displayUpdatePending(0)
+		, lastRenderError(noErr), lastRenderErrorChanged(0), stateLoadsPending(0), presetIsFXB(false)
+		, classInfoSnapshot(0), classInfoSnapshotIsFXB(false), classInfoSnapshotName(0), classInfoSnapshotGeneration(0)
+		, classInfoSnapshotCounter(0), autoConvertPresets(false), updateNameOnLoad(false)
+		, canDoMonoIO(false), subBlockMinFrames(0), fixedBlockSize(0), vst(0), scheduledParameterCount(0), rampControlFrames(0)
+		, activeRampCount(0), vstGotSymbiosisExtensions(false), vstSupportsTail(false), initialDelayTime(0.0)
+		, tailTime(0.0), silenceTailFrames(-1), silenceCountdown(0), vstSupportsBypass(false), isBypassing(false)
+		, vstCanProcessInPlace(true), inPlaceProcessing(true), vstWantsMidi(false), sysExArena(0), sysExArenaUsed(0)
+		, vstSendsMidi(false), renderThread(0), renderBlockOffset(0), vstProcessOffset(0), midiOutputEventCount(0)
 		, inputBusCount(0), outputBusCount(0), auChannelInfoCount(0), hostApplication(undetermined), idleTimerRef(0)
 	#if (SY_INCLUDE_GUI_SUPPORT)
 	#if (SY_USE_COCOA_GUI)
@@ -2732,11 +4305,20 @@ SymbiosisComponent::SymbiosisComponent(::AudioUnit auComponentInstance, const ::
 	memset(&inputConnections, 0, sizeof (inputConnections));
 	memset(&renderCallbacks, 0, sizeof (renderCallbacks));
 	memset(&ioBuffers, 0, sizeof (ioBuffers));
+	memset(&fifoInputBuffers, 0, sizeof (fifoInputBuffers));
+	memset(&fifoOutputBuffers, 0, sizeof (fifoOutputBuffers));
 	memset(&hostCallbackInfo, 0, sizeof (hostCallbackInfo));
 	memset(&currentAUPreset, 0, sizeof (currentAUPreset));
+	memset(currentVSTProgramName, 0, sizeof (currentVSTProgramName));
 	memset(factoryPresets, 0, sizeof (factoryPresets));
 	memset(factoryPresetData, 0, sizeof (factoryPresetData));
 	memset(&vstMidiEvents, 0, sizeof (vstMidiEvents));
+	memset(&vstSubBlockEvents, 0, sizeof (vstSubBlockEvents));
+	memset(&midiOutputCallback, 0, sizeof (midiOutputCallback));
+	memset(scheduledParameters, 0, sizeof (scheduledParameters));
+	memset(&parameterSmoothers, 0, sizeof (parameterSmoothers));
+	memset(&parameterCurves, 0, sizeof (parameterCurves));
+	std::fill(midiMap, midiMap + 16 * 128, -1);
 	memset(&vstTimeInfo, 0, sizeof (vstTimeInfo));
 	memset(inputBusChannelNumbers, 0, sizeof (inputBusChannelNumbers));
 	memset(inputBusChannelCounts, 0, sizeof (inputBusChannelCounts));
@@ -2771,12 +4353,15 @@ SymbiosisComponent::SymbiosisComponent(::AudioUnit auComponentInstance, const ::
 
 		for (int i = 0; i < kMaxVSTMIDIEvents; ++i) {
 			if (vstMidiEvents.events[i] == 0) {
-				vstMidiEvents.events[i] = reinterpret_cast<VstEvent*>(new VstMidiEvent);
-				memset(vstMidiEvents.events[i], 0, sizeof (VstMidiEvent));
+				vstMidiEvents.events[i] = reinterpret_cast<VstEvent*>(new SymbiosisVstEventStorage);
+				memset(vstMidiEvents.events[i], 0, sizeof (SymbiosisVstEventStorage));
 				vstMidiEvents.events[i]->type = kVstMidiType;
 				vstMidiEvents.events[i]->byteSize = 24;
 			}
 		}
+		if (sysExArena == 0) {
+			sysExArena = new unsigned char[kSysExArenaSize];
+		}
 
 		// --- Find ourselves and load configuration from info.plist
 
@@ -2853,7 +4438,8 @@ SymbiosisComponent::SymbiosisComponent(::AudioUnit auComponentInstance, const ::
 		
 		// --- Create and initialize VST plug-in
 
-		vst = new VSTPlugIn(*this, vstBundleRef, static_cast<float>(streamFormat.mSampleRate), maxFramesPerSlice);
+		vst = new VSTPlugIn(*this, vstBundleRef, static_cast<float>(streamFormat.mSampleRate)
+				, (fixedBlockSize > 0 ? fixedBlockSize : maxFramesPerSlice));
 		releaseBundleRef(vstBundleRef);
 		vst->open();
 		
@@ -2872,12 +4458,17 @@ SymbiosisComponent::SymbiosisComponent(::AudioUnit auComponentInstance, const ::
 			throw SymbiosisException("VST does not support processReplacing()");
 		}
 		vstGotSymbiosisExtensions = (vst->vendorSpecific('sHi!', 0, 0, 0) != 0);
+		vstCanProcessInPlace = !vstGotSymbiosisExtensions || (vst->vendorSpecific('sNIP', 0, 0, 0) == 0);
+		inPlaceProcessing = vstCanProcessInPlace;
 		vstSupportsTail = (vst->getTailSize() != 0);
 		vstSupportsBypass = vst->setBypass(false);
+		vstSendsMidi = vst->sendsMidi();
 		SY_TRACE1(SY_TRACE_MISC, "VST %s Symbiosis extensions"
 				, (vstGotSymbiosisExtensions ? "supports" : "does not support"));
 		SY_TRACE1(SY_TRACE_MISC, "VST %s tail size", (vstSupportsTail ? "supports" : "does not support"));
 		SY_TRACE1(SY_TRACE_MISC, "VST %s bypassing", (vstSupportsBypass ? "supports" : "does not support"));
+		SY_TRACE1(SY_TRACE_MISC, "VST %s MIDI output", (vstSendsMidi ? "supports" : "does not support"));
+		SY_TRACE1(SY_TRACE_MISC, "VST %s in-place processing", (vstCanProcessInPlace ? "supports" : "does not support"));
 		SY_ASSERT0(!vstSupportsTail || !vst->dontProcessSilence()
 				, "VST supports tail but has flagged not to process silent input, makes no sense!")
 		
@@ -3022,17 +4613,19 @@ SymbiosisComponent::SymbiosisComponent(::AudioUnit auComponentInstance, const ::
 		
 		// --- Allocate parameters and audio buffers
 		
-		SY_ASSERT(parameterValueStrings == 0);
-		parameterValueStrings = new ::CFArrayRef[vst->getParameterCount()];
-		memset(parameterValueStrings, 0, sizeof (::CFArrayRef) * vst->getParameterCount());
-		SY_ASSERT(parameterInfos == 0);
-		parameterInfos = new ::AudioUnitParameterInfo[vst->getParameterCount()];
-		memset(parameterInfos, 0, sizeof (::AudioUnitParameterInfo) * vst->getParameterCount());
+		SY_ASSERT(parameterSlots == 0);
+		parameterSlots = new int[vst->getParameterCount()];
+		std::fill(parameterSlots, parameterSlots + vst->getParameterCount(), -1);
+		SY_ASSERT(pendingParameterNotifications == 0);
+		pendingParameterNotifications = new ::uint32_t[(vst->getParameterCount() + 31) / 32 + 1];
+		memset(const_cast< ::uint32_t* >(pendingParameterNotifications), 0
+				, sizeof (::uint32_t) * ((vst->getParameterCount() + 31) / 32 + 1));
 		reallocateIOBuffers();
 		
 		// --- Load (or create) various AU wrapping configurations and convert presets
 		
 		readOrCreateParameterMapping();
+		readMIDIMap();
 		loadOrCreateFactoryPresets();
 		if (autoConvertPresets) {
 			convertVSTPresets();
@@ -3064,24 +4657,36 @@ SymbiosisComponent::SymbiosisComponent(::AudioUnit auComponentInstance, const ::
 
 float SymbiosisComponent::scaleFromAUParameter(int parameterIndex, float auValue) {
 	SY_ASSERT(parameterIndex >= 0 && parameterIndex < vst->getParameterCount());
-	const ::AudioUnitParameterInfo& parameterInfo = parameterInfos[parameterIndex];
-	SY_ASSERT(auValue >= parameterInfo.minValue && auValue <= parameterInfo.maxValue);
-	return (auValue - parameterInfo.minValue) / (parameterInfo.maxValue - parameterInfo.minValue);
+	const int slot = parameterSlots[parameterIndex];
+	SY_ASSERT(slot >= 0);
+	SY_ASSERT(auValue >= parameterInfos[slot].minValue && auValue <= parameterInfos[slot].maxValue);
+	const float n = (auValue - parameterCurves.minValues[slot]) / parameterCurves.ranges[slot];
+	return denormalizeAUValue(parameterCurves, slot, n);
+}
+
+/**
+	Same as scaleFromAUParameter() for \p count parameters at once, in a single loop over the compiled curves.
+	\p vstValues may be the same array as \p auValues.
+*/
+void SymbiosisComponent::scaleFromAUParameters(int count, const int* parameterIndexes, const float* auValues
+		, float* vstValues) {
+	for (int i = 0; i < count; ++i) {
+		SY_ASSERT(isMappedParameter(parameterIndexes[i]));
+		const int j = parameterSlots[parameterIndexes[i]];
+		SY_ASSERT(auValues[i] >= parameterInfos[j].minValue && auValues[i] <= parameterInfos[j].maxValue);
+		vstValues[i] = denormalizeAUValue(parameterCurves, j
+				, (auValues[i] - parameterCurves.minValues[j]) / parameterCurves.ranges[j]);
+	}
 }
 
 float SymbiosisComponent::scaleToAUParameter(int parameterIndex, float vstValue) {
 	SY_ASSERT(parameterIndex >= 0 && parameterIndex < vst->getParameterCount());
 	SY_ASSERT(vstValue >= 0.0f && vstValue <= 1.0f);
-	const ::AudioUnitParameterInfo& parameterInfo = parameterInfos[parameterIndex];
-	switch (parameterInfo.unit) {
-		default: SY_ASSERT(0);
-		case kAudioUnitParameterUnit_Generic:
-		case kAudioUnitParameterUnit_CustomUnit:
-			return parameterInfo.minValue + vstValue * (parameterInfo.maxValue - parameterInfo.minValue);
-		case kAudioUnitParameterUnit_Boolean:
-		case kAudioUnitParameterUnit_Indexed:
-			return floorf(parameterInfo.minValue + vstValue * (parameterInfo.maxValue - parameterInfo.minValue) + 0.5f);
-	}
+	const int slot = parameterSlots[parameterIndex];
+	SY_ASSERT(slot >= 0);
+	const float auValue = parameterCurves.minValues[slot]
+			+ normalizeVSTValue(parameterCurves, slot, vstValue) * parameterCurves.ranges[slot];
+	return (parameterCurves.isQuantized[slot] ? floorf(auValue + 0.5f) : auValue);
 }
 
 void SymbiosisComponent::getVendor(VSTPlugIn& plugIn, char vendor[63 + 1]) {
@@ -3104,6 +4709,8 @@ bool SymbiosisComponent::canDo(VSTPlugIn& plugIn, const char string[]) {
 	SY_ASSERT(string != 0);
 	if (strcmp(string, "sendVstEvents") == 0
 			|| strcmp(string, "sendVstMidiEvent") == 0
+			|| strcmp(string, "receiveVstEvents") == 0
+			|| strcmp(string, "receiveVstMidiEvent") == 0
 			|| strcmp(string, "sendVstTimeInfo") == 0
 			|| strcmp(string, "reportConnectionChanges") == 0
 			|| strcmp(string, "sizeWindow") == 0
@@ -3114,6 +4721,58 @@ bool SymbiosisComponent::canDo(VSTPlugIn& plugIn, const char string[]) {
 	}
 }
 
+static int getMIDIMessageLength(int status) {
+	switch (status & 0xF0) {
+		case 0x80: case 0x90: case 0xA0: case 0xB0: case 0xE0: return 3;
+		case 0xC0: case 0xD0: return 2;
+		case 0xF0:
+			switch (status) {
+				case 0xF1: case 0xF3: return 2;
+				case 0xF2: return 3;
+				case 0xF6: case 0xF8: case 0xFA: case 0xFB: case 0xFC: case 0xFE: case 0xFF: return 1;
+				default: return 0;																						// SysEx (which does not fit in a VstMidiEvent) or undefined.
+			}
+		default: return 0;																								// Running status is not allowed in VstMidiEvent.
+	}
+}
+
+/**
+	Collects MIDI output from the VST into midiOutputEvents for deliverMIDIOutput(). This is called on the render
+	thread from within processReplacing(), so it never allocates. Events sent from other threads (or outside of
+	render) are ignored since the buffer is owned by the render thread, as are SysEx events.
+*/
+void SymbiosisComponent::processEvents(VSTPlugIn& plugIn, const VstEvents& events) {
+	(void)plugIn;
+	SY_ASSERT(&plugIn == vst);
+	if (midiOutputCallback.midiOutputCallback == 0) {
+		return;
+	}
+	if (renderInProgress == 0 || !::pthread_equal(::pthread_self(), renderThread)) {
+		SY_TRACE(SY_TRACE_MISC, "VST sent events outside of processing, ignoring");
+		return;
+	}
+	for (int i = 0; i < events.numEvents; ++i) {
+		const VstEvent* e = events.events[i];
+		if (e == 0 || e->type != kVstMidiType) {
+			continue;
+		}
+		const VstMidiEvent* midiEvent = reinterpret_cast<const VstMidiEvent*>(e);
+		const int length = getMIDIMessageLength(static_cast<unsigned char>(midiEvent->midiData[0]));
+		if (length == 0) {
+			continue;
+		}
+		if (midiOutputEventCount >= kMaxMIDIOutputEvents) {
+			SY_TRACE(1, "Too many MIDI output events from VST, dropping");
+			break;
+		}
+		SymbiosisMIDIOutputEvent& outputEvent = midiOutputEvents[midiOutputEventCount];
+		outputEvent.offset = vstProcessOffset + std::max(0, static_cast<int>(midiEvent->deltaFrames));
+		outputEvent.length = length;
+		memcpy(outputEvent.data, midiEvent->midiData, 3);
+		++midiOutputEventCount;
+	}
+}
+
 VstInt32 VSTPlugIn::getVersion() {
 	SY_TRACE(SY_TRACE_VST, "VST getVersion");
 	return static_cast<VstInt32>(dispatch(effGetVstVersion, 0, 0, 0, 0));
@@ -3135,6 +4794,8 @@ void SymbiosisComponent::beginEdit(VSTPlugIn& plugIn, int parameterIndex) {
 
 	if (parameterIndex < 0 || parameterIndex >= vst->getParameterCount()) return;
 
+	flushParameterNotification(parameterIndex);																			// Keep value changes inside the gesture they belong to.
+
 	::AudioUnitEvent myEvent;
 	memset(&myEvent, 0, sizeof (::AudioUnitEvent));
 	myEvent.mArgument.mParameter.mAudioUnit = auComponentInstance;
@@ -3160,10 +4821,41 @@ void SymbiosisComponent::beginEdit(VSTPlugIn& plugIn, int parameterIndex) {
 	}
 }
 
+/**
+	Plug-ins call this from any thread (often the render thread) and sometimes thousands of times per second, so we
+	only mark the parameter here. The notifications are sent from idleTimerAction(), once per parameter and tick (the
+	listeners read the latest value themselves).
+*/
 void SymbiosisComponent::automate(VSTPlugIn& plugIn, int parameterIndex, float /*value*/) {
 	(void)plugIn;
 	SY_ASSERT(&plugIn == vst);
 	SY_ASSERT(parameterIndex >= 0 && parameterIndex < vst->getParameterCount());
+	::OSAtomicOr32Barrier(1U << (parameterIndex & 31), &pendingParameterNotifications[parameterIndex >> 5]);
+}
+
+void SymbiosisComponent::flushParameterNotification(int parameterIndex) {
+	const ::uint32_t mask = 1U << (parameterIndex & 31);
+	if ((::OSAtomicAnd32OrigBarrier(~mask, &pendingParameterNotifications[parameterIndex >> 5]) & mask) != 0) {
+		notifyParameterChange(parameterIndex);
+	}
+}
+
+void SymbiosisComponent::flushParameterNotifications() {
+	const int wordCount = (vst->getParameterCount() + 31) / 32;
+	for (int i = 0; i < wordCount; ++i) {
+		if (pendingParameterNotifications[i] != 0) {
+			::uint32_t bits = ::OSAtomicAnd32OrigBarrier(0, &pendingParameterNotifications[i]);
+			for (int j = 0; bits != 0; ++j, bits >>= 1) {
+				if ((bits & 1) != 0) {
+					notifyParameterChange(i * 32 + j);
+				}
+			}
+		}
+	}
+}
+
+void SymbiosisComponent::notifyParameterChange(int parameterIndex) {
+	SY_ASSERT(parameterIndex >= 0 && parameterIndex < vst->getParameterCount());
 
 	::AudioUnitEvent myEvent;
 	memset(&myEvent, 0, sizeof (::AudioUnitEvent));
@@ -3174,7 +4866,9 @@ void SymbiosisComponent::automate(VSTPlugIn& plugIn, int parameterIndex, float /
 
 	// Old style
 	SY_TRACE1(SY_TRACE_FREQUENT, "Calling AUParameterListenerNotify for parameter %d", parameterIndex);
-	throwOnOSError(::AUParameterListenerNotify(0, 0, &myEvent.mArgument.mParameter));
+	const ::OSStatus status = ::AUParameterListenerNotify(0, 0, &myEvent.mArgument.mParameter);
+	(void)status;
+	SY_ASSERT1(status == noErr, "AUParameterListenerNotify failed: %d", static_cast<int>(status));
 
 	// New style
 	SY_TRACE1(SY_TRACE_FREQUENT, "Notifying kAudioUnitEvent_ParameterValueChange on parameter %d", parameterIndex);
@@ -3192,6 +4886,8 @@ void SymbiosisComponent::endEdit(VSTPlugIn& plugIn, int parameterIndex) {
 
 	if (parameterIndex < 0 || parameterIndex >= vst->getParameterCount()) return;
 
+	flushParameterNotification(parameterIndex);																			// Keep value changes inside the gesture they belong to.
+
 	::AudioUnitEvent myEvent;
 	memset(&myEvent, 0, sizeof (::AudioUnitEvent));
 	myEvent.mArgument.mParameter.mAudioUnit = auComponentInstance;
@@ -3227,13 +4923,14 @@ bool SymbiosisComponent::isIOPinConnected(VSTPlugIn& plugIn, bool checkOutputPin
 	return true;
 }
 
+/**
+	Some plug-ins call this on every processing block (from the render thread), so we only flag it here and let
+	idleTimerAction() check the preset name and notify the property listeners.
+*/
 void SymbiosisComponent::updateDisplay(VSTPlugIn& plugIn) {
 	(void)plugIn;
 	SY_ASSERT(&plugIn == vst);
-	if (updateCurrentAUPreset()) {
-		propertyChanged(kAudioUnitProperty_CurrentPreset, kAudioUnitScope_Global, 0);
-		propertyChanged(kAudioUnitProperty_PresentPreset, kAudioUnitScope_Global, 0);
-	}
+	displayUpdatePending = 1;
 }
 
 void SymbiosisComponent::resizeWindow(VSTPlugIn& plugIn, int width, int height) {
@@ -3255,15 +4952,31 @@ void SymbiosisComponent::resizeWindow(VSTPlugIn& plugIn, int width, int height)
 void SymbiosisComponent::idleTimerAction(::EventLoopTimerRef /*theTimer*/, void* theUserData) {
 	SymbiosisComponent* Symbiosis = reinterpret_cast<SymbiosisComponent*>(theUserData);
 	Symbiosis->vst->idle();
+	Symbiosis->vst->reconcileParameterCache(kParameterCacheStaleReadCount, kParameterCacheSweepCount);
+	Symbiosis->flushParameterNotifications();
+	if (::OSAtomicCompareAndSwap32Barrier(1, 0, &Symbiosis->lastRenderErrorChanged)) {
+		Symbiosis->propertyChanged(kAudioUnitProperty_LastRenderError, kAudioUnitScope_Global, 0);
+	}
+	if (::OSAtomicCompareAndSwap32Barrier(1, 0, &Symbiosis->displayUpdatePending)) {
+		try {
+			if (Symbiosis->updateCurrentAUPreset()) {
+				Symbiosis->propertyChanged(kAudioUnitProperty_CurrentPreset, kAudioUnitScope_Global, 0);
+				Symbiosis->propertyChanged(kAudioUnitProperty_PresentPreset, kAudioUnitScope_Global, 0);
+			}
+		}
+		catch (const std::exception& x) {
+			SY_TRACE1(SY_TRACE_EXCEPTIONS, "Failed updating current preset, caught exception: %s", x.what());
+			// No throw!
+		}
+	}
 }
 
 void SymbiosisComponent::propertyChanged(::AudioUnitPropertyID id, ::AudioUnitScope scope, ::AudioUnitElement element) {
 	// Old style
-	for (int i = 0; i < propertyListenersCount; ++i) {
-		if (id == propertyListeners[i].fPropertyID) {
-			(*propertyListeners[i].fListenerProc)(propertyListeners[i].fListenerRefCon, auComponentInstance, id, scope
-					, element);
-		}
+	const AUPropertyListener* const end = propertyListeners + propertyListenersCount;
+	for (const AUPropertyListener* it = std::lower_bound(propertyListeners, end, id, propertyListenerPrecedes)
+			; it != end && it->fPropertyID == id; ++it) {
+		(*it->fListenerProc)(it->fListenerRefCon, auComponentInstance, id, scope, element);
 	}
 	
 	// New style
@@ -3293,12 +5006,17 @@ void SymbiosisComponent::updateCurrentVSTProgramName(::CFStringRef presetName) {
 }
 
 bool SymbiosisComponent::updateCurrentAUPreset() {
+	char programName[24 + 1] = "";
+	vst->getCurrentProgramName(programName);
+	if (currentVSTProgramNameValid && strncmp(programName, currentVSTProgramName, 24) == 0) {
+		return false;
+	}
 	::CFStringRef newPresetName = 0;		
 	try {
-		char programName[24 + 1] = "";
-		vst->getCurrentProgramName(programName);
 		newPresetName = ::CFStringCreateWithCString(0, programName, kCFStringEncodingMacRoman);
 		SY_ASSERT(newPresetName != 0);
+		strcpy(currentVSTProgramName, programName);
+		currentVSTProgramNameValid = true;
 		if (::CFStringCompare(currentAUPreset.presetName, newPresetName, 0) != kCFCompareEqualTo) {
 			releaseCFRef((::CFTypeRef*)&currentAUPreset.presetName);
 			currentAUPreset.presetNumber = -1;
@@ -3394,8 +5112,7 @@ void SymbiosisComponent::getPropertyInfo(::AudioUnitPropertyID id, ::AudioUnitSc
 			SY_TRACE2(SY_TRACE_AU, "AU GetPropertyInfo: kAudioUnitProperty_ParameterInfo (scope: %d, element: %d)"
 					, static_cast<int>(scope), static_cast<int>(element));
 			if (scope != kAudioUnitScope_Global) throw MacOSException(kAudioUnitErr_InvalidScope);
-			if (static_cast<int>(element) < 0 || static_cast<int>(element) >= vst->getParameterCount())
-				throw MacOSException(kAudioUnitErr_InvalidElement);
+			if (!isMappedParameter(element)) throw MacOSException(kAudioUnitErr_InvalidElement);
 			(*isReadable) = true;
 			(*isWritable) = false;
 			(*minDataSize) = sizeof (::AudioUnitParameterInfo);
@@ -3409,7 +5126,8 @@ void SymbiosisComponent::getPropertyInfo(::AudioUnitPropertyID id, ::AudioUnitSc
 			if (scope != kAudioUnitScope_Global) throw MacOSException(kAudioUnitErr_InvalidScope);
 			if (static_cast<int>(element) < 0 || static_cast<int>(element) >= vst->getParameterCount())
 				throw MacOSException(kAudioUnitErr_InvalidElement);
-			if (parameterValueStrings[element] == 0) throw MacOSException(kAudioUnitErr_InvalidParameter);
+			if (!isMappedParameter(element) || parameterValueStrings[parameterSlots[element]] == 0)
+				throw MacOSException(kAudioUnitErr_InvalidParameter);
 			(*isReadable) = true;
 			(*isWritable) = false;
 			(*minDataSize) = sizeof (::CFArrayRef);
@@ -3480,6 +5198,29 @@ void SymbiosisComponent::getPropertyInfo(::AudioUnitPropertyID id, ::AudioUnitSc
 			(*normalDataSize) = sizeof (::OSStatus);
 			break;
 
+		case kAudioUnitProperty_MIDIOutputCallbackInfo:
+			SY_TRACE2(SY_TRACE_AU
+					, "AU GetPropertyInfo: kAudioUnitProperty_MIDIOutputCallbackInfo (scope: %d, element: %d)"
+					, static_cast<int>(scope), static_cast<int>(element));
+			if (scope != kAudioUnitScope_Global) throw MacOSException(kAudioUnitErr_InvalidScope);
+			if (!vstSendsMidi) throw MacOSException(kAudioUnitErr_InvalidProperty);
+			(*isReadable) = true;
+			(*isWritable) = false;
+			(*minDataSize) = sizeof (::CFArrayRef);
+			(*normalDataSize) = sizeof (::CFArrayRef);
+			break;
+
+		case kAudioUnitProperty_MIDIOutputCallback:
+			SY_TRACE2(SY_TRACE_AU, "AU GetPropertyInfo: kAudioUnitProperty_MIDIOutputCallback (scope: %d, element: %d)"
+					, static_cast<int>(scope), static_cast<int>(element));
+			if (scope != kAudioUnitScope_Global) throw MacOSException(kAudioUnitErr_InvalidScope);
+			if (!vstSendsMidi) throw MacOSException(kAudioUnitErr_InvalidProperty);
+			(*isReadable) = false;
+			(*isWritable) = true;
+			(*minDataSize) = sizeof (::AUMIDIOutputCallbackStruct);
+			(*normalDataSize) = sizeof (::AUMIDIOutputCallbackStruct);
+			break;
+
 		case kAudioUnitProperty_FactoryPresets:
 			SY_TRACE2(SY_TRACE_AU, "AU GetPropertyInfo: kAudioUnitProperty_FactoryPresets (scope: %d, element: %d)"
 					, static_cast<int>(scope), static_cast<int>(element));
@@ -3638,6 +5379,20 @@ void SymbiosisComponent::getPropertyInfo(::AudioUnitPropertyID id, ::AudioUnitSc
 			}
 			break;
 
+		case kAudioUnitProperty_InPlaceProcessing:
+			SY_TRACE2(SY_TRACE_AU, "AU GetPropertyInfo: kAudioUnitProperty_InPlaceProcessing (scope: %d, element: %d)"
+					, static_cast<int>(scope), static_cast<int>(element));
+			if (scope != kAudioUnitScope_Global) throw MacOSException(kAudioUnitErr_InvalidScope);
+			if (inputBusCount == 0) {
+				throw MacOSException(kAudioUnitErr_InvalidProperty);
+			} else {
+				(*isReadable) = true;
+				(*isWritable) = vstCanProcessInPlace;
+				(*minDataSize) = sizeof (::UInt32);
+				(*normalDataSize) = sizeof (::UInt32);
+			}
+			break;
+
 		case kMusicDeviceProperty_InstrumentCount:
 			SY_TRACE2(SY_TRACE_AU, "AU GetPropertyInfo: kMusicDeviceProperty_InstrumentCount (scope: %d, element: %d)"
 					, static_cast<int>(scope), static_cast<int>(element));
@@ -3749,120 +5504,813 @@ void SymbiosisComponent::updateVSTTimeInfo(const ::AudioTimeStamp* inTimeStamp)
 	}
 }
 
-bool SymbiosisComponent::collectInputAudio(int frameCount, float** inputPointers, const ::AudioTimeStamp* timeStamp) {
-	bool inputIsSilent = true;
-	 
-	SymbiosisAudioBufferList bufferList;
-	memset(&bufferList, 0, sizeof (bufferList));
-	
-	int ioChannelIndex = 0;
-	for (int inputBusIndex = 0; inputBusIndex < inputBusCount; ++inputBusIndex) {
-		int maxChannelCount = getMaxInputChannels(inputBusIndex);
-		int activeChannelCount = getActiveInputChannels(inputBusIndex);
-		bufferList.mNumberBuffers = activeChannelCount;
-		for (int i = 0; i < activeChannelCount; ++i) {
-			bufferList.mBuffers[i].mNumberChannels = 1;
-			bufferList.mBuffers[i].mDataByteSize = frameCount * 4;
-			bufferList.mBuffers[i].mData = ioBuffers[ioChannelIndex + i];
+/**
+	Pulls input into ioBuffers, or into \p inPlaceBuffers if it is not 0 (there must then be a single input bus with the
+	same channel layout as the output bus). \p inputPointers receives the pointers to the actual input data, which may
+	also point into the buffers of the audio unit that is connected to the input. If the stream format needs conversion,
+	input is pulled into the conversion buffer and converted into ioBuffers. Called on the render thread, so errors are
+	returned (never thrown).
+*/
+template<typename T> ::OSStatus SymbiosisComponent::collectInputAudio(int frameCount, T** inputPointers
+		, const ::AudioTimeStamp* timeStamp, const ::AudioBufferList* inPlaceBuffers, bool* inputIsSilent) {
+	SY_ASSERT(sizeof (T) == vstSampleBytes);
+	const bool convert = needsSampleConversion();
+	SY_ASSERT(inPlaceBuffers == 0 || inputBusCount == 1);
+	SY_ASSERT(inPlaceBuffers == 0 || !convert);
+	SY_ASSERT(inputIsSilent != 0);
+	(*inputIsSilent) = true;
+	 
+	SymbiosisAudioBufferList bufferList;
+	memset(&bufferList, 0, sizeof (bufferList));
+	
+	int ioChannelIndex = 0;
+	for (int inputBusIndex = 0; inputBusIndex < inputBusCount; ++inputBusIndex) {
+		int maxChannelCount = getMaxInputChannels(inputBusIndex);
+		int activeChannelCount = getActiveInputChannels(inputBusIndex);
+		const int channelsPerBuffer = (streamIsInterleaved ? activeChannelCount : 1);
+		bufferList.mNumberBuffers = activeChannelCount / channelsPerBuffer;
+		for (int i = 0; i < static_cast<int>(bufferList.mNumberBuffers); ++i) {
+			bufferList.mBuffers[i].mNumberChannels = channelsPerBuffer;
+			bufferList.mBuffers[i].mDataByteSize = frameCount * streamSampleBytes * channelsPerBuffer;
+			if (inPlaceBuffers != 0) {
+				bufferList.mBuffers[i].mData = inPlaceBuffers->mBuffers[i].mData;
+			} else if (convert) {
+				bufferList.mBuffers[i].mData = getConversionBuffer(ioChannelIndex + i);
+			} else {
+				bufferList.mBuffers[i].mData = ioBuffers[ioChannelIndex + i];
+			}
+		}
+		::AudioUnitRenderActionFlags inputFlags = 0;
+		::OSStatus status = noErr;
+		if (renderCallbacks[inputBusIndex].inputProc != 0) {
+			status = (*renderCallbacks[inputBusIndex].inputProc)(renderCallbacks[inputBusIndex].inputProcRefCon
+					, &inputFlags, timeStamp, inputBusIndex, frameCount
+					, reinterpret_cast< ::AudioBufferList* >(&bufferList));
+		} else if (inputConnections[inputBusIndex].sourceAudioUnit != 0) {			
+			for (int i = 0; i < static_cast<int>(bufferList.mNumberBuffers) && inPlaceBuffers == 0; ++i) {				// When processing in place we want the input in our output buffers, otherwise we can use the source's buffers directly.
+				bufferList.mBuffers[i].mData = 0;
+			}
+			status = ::AudioUnitRender(inputConnections[inputBusIndex].sourceAudioUnit, &inputFlags, timeStamp
+					, inputConnections[inputBusIndex].sourceOutputNumber, frameCount
+					, reinterpret_cast< ::AudioBufferList* >(&bufferList));
+		} else {
+			for (int i = 0; i < static_cast<int>(bufferList.mNumberBuffers); ++i) {
+				memset(bufferList.mBuffers[i].mData, 0, bufferList.mBuffers[i].mDataByteSize);
+			}
+			inputFlags = kAudioUnitRenderAction_OutputIsSilence;
+		}
+		if (status != noErr) {
+			SY_TRACE2(SY_TRACE_FREQUENT, "Failed pulling input bus %d (error: %d)", inputBusIndex, static_cast<int>(status));
+			return status;
+		}
+		(*inputIsSilent) = (*inputIsSilent) && ((inputFlags & kAudioUnitRenderAction_OutputIsSilence) != 0);
+		if (convert) {
+			for (int i = 0; i < activeChannelCount; ++i) {
+				const unsigned char* source = (streamIsInterleaved
+						? reinterpret_cast<const unsigned char*>(bufferList.mBuffers[0].mData) + i * streamSampleBytes
+						: reinterpret_cast<const unsigned char*>(bufferList.mBuffers[i].mData));
+				decodeSamples(streamSampleFormat, source, channelsPerBuffer
+						, reinterpret_cast<T*>(ioBuffers[ioChannelIndex + i]), frameCount);
+			}
+		}
+		for (int i = 0; i < maxChannelCount; ++i) {
+			inputPointers[ioChannelIndex + i] = (convert
+					? reinterpret_cast<T*>(ioBuffers[ioChannelIndex + i % activeChannelCount])
+					: reinterpret_cast<T*>(bufferList.mBuffers[i % activeChannelCount].mData));
+		}
+		ioChannelIndex += maxChannelCount;
+	}
+	SY_ASSERT(ioChannelIndex == vst->getInputCount());
+	
+#if (!defined(NDEBUG))
+	if (*inputIsSilent) {
+		bool gotSignal = false;
+		for (int i = 0; i < vst->getInputCount() && !gotSignal; ++i) {
+			for (int j = 0; j < frameCount && !gotSignal; ++j) {
+				gotSignal = (inputPointers[i][j] != 0.0);
+			}
+		}
+		SY_ASSERT0(!gotSignal, "Input was flagged silent when signal was not (may be bug in signal source)");
+	}
+#endif
+	
+	return noErr;
+}
+
+void SymbiosisComponent::scheduleParameterRamp(int parameter, int startOffset, int durationFrames, float startValue
+		, float endValue) {
+	int i = 0;
+	while (i < activeRampCount && activeRamps[i].parameter != parameter) {
+		++i;
+	}
+	const float endVSTValue = scaleFromAUParameter(parameter, endValue);
+	if (i >= parameterCount) {
+		SY_TRACE1(SY_TRACE_AU, "Too many active parameter ramps, jumping to end value for parameter %d", parameter);
+		setParameterUnsmoothed(parameter, endVSTValue);
+		return;
+	}
+	activeRamps[i].parameter = parameter;
+	activeRamps[i].startOffset = startOffset;
+	activeRamps[i].durationFrames = durationFrames;
+	activeRamps[i].startValue = startValue;
+	activeRamps[i].endValue = endValue;
+	activeRamps[i].endVSTValue = endVSTValue;
+	if (i == activeRampCount) {
+		++activeRampCount;
+	}
+}
+
+/**
+	Sets all active ramps to their interpolated values at frame \p offset of the current slice. Ramps that have reached
+	their end value are removed.
+*/
+void SymbiosisComponent::updateParameterRamps(int offset) {
+	int count = 0;
+	int i = 0;
+	while (i < activeRampCount) {
+		SymbiosisParameterRamp& ramp = activeRamps[i];
+		const int elapsed = offset - ramp.startOffset;
+		if (elapsed < 0) {
+			++i;
+		} else if (elapsed >= ramp.durationFrames) {
+			setParameterUnsmoothed(ramp.parameter, ramp.endVSTValue);
+			--activeRampCount;
+			activeRamps[i] = activeRamps[activeRampCount];
+		} else {
+			const float t = static_cast<float>(elapsed) / static_cast<float>(ramp.durationFrames);
+			rampParameters[count] = ramp.parameter;
+			rampValues[count] = ramp.startValue + (ramp.endValue - ramp.startValue) * t;
+			++count;
+			++i;
+		}
+	}
+	scaleFromAUParameters(count, rampParameters, rampValues, rampValues);
+	for (int j = 0; j < count; ++j) {
+		setParameterUnsmoothed(rampParameters[j], rampValues[j]);
+	}
+}
+
+void SymbiosisComponent::finishParameterRamps() {
+	for (int i = 0; i < activeRampCount; ++i) {
+		setParameterUnsmoothed(activeRamps[i].parameter, activeRamps[i].endVSTValue);
+	}
+	activeRampCount = 0;
+}
+
+void SymbiosisComponent::allocateParameterSmoothers(int capacity) {
+	SY_ASSERT(parameterSmoothers.parameters == 0);
+	parameterSmoothers.count = 0;
+	parameterSmoothers.parameters = new int[capacity];
+	parameterSmoothers.times = new float[capacity];
+	parameterSmoothers.isExponential = new bool[capacity];
+	parameterSmoothers.coefficients = new float[capacity];
+	parameterSmoothers.maxSteps = new float[capacity];
+	parameterSmoothers.current = new float[capacity];
+	parameterSmoothers.target = new float[capacity];
+	parameterSmoothers.sent = new float[capacity];
+}
+
+void SymbiosisComponent::allocateParameterCurves(int capacity) {
+	SY_ASSERT(parameterCurves.minValues == 0);
+	parameterCurves.minValues = new float[capacity];
+	parameterCurves.ranges = new float[capacity];
+	parameterCurves.steepness = new float[capacity];
+	parameterCurves.scales = new float[capacity];
+	parameterCurves.offsets = new float[capacity];
+	parameterCurves.isPower = new bool[capacity];
+	parameterCurves.isQuantized = new bool[capacity];
+	parameterCurves.tableStarts = new int[capacity];
+	parameterCurves.tableSizes = new int[capacity];
+	parameterCurves.tableValues = 0;
+	parameterCurves.tableValueCount = 0;
+	parameterCurves.tableValueCapacity = 0;
+	for (int i = 0; i < capacity; ++i) {
+		parameterCurves.minValues[i] = 0.0f;
+		parameterCurves.ranges[i] = 1.0f;
+		parameterCurves.steepness[i] = 0.0f;
+		parameterCurves.scales[i] = 1.0f;
+		parameterCurves.offsets[i] = 0.0f;
+		parameterCurves.isPower[i] = false;
+		parameterCurves.isQuantized[i] = false;
+		parameterCurves.tableStarts[i] = -1;
+		parameterCurves.tableSizes[i] = 0;
+	}
+}
+
+void SymbiosisComponent::releaseParameterCurves() {
+	delete [] parameterCurves.minValues;
+	delete [] parameterCurves.ranges;
+	delete [] parameterCurves.steepness;
+	delete [] parameterCurves.scales;
+	delete [] parameterCurves.offsets;
+	delete [] parameterCurves.isPower;
+	delete [] parameterCurves.isQuantized;
+	delete [] parameterCurves.tableStarts;
+	delete [] parameterCurves.tableSizes;
+	delete [] parameterCurves.tableValues;
+	memset(&parameterCurves, 0, sizeof (parameterCurves));
+}
+
+/**
+	Compiles the curve of \p mapping (already validated by the SYParameters.txt parser) into parameterCurves.
+*/
+void SymbiosisComponent::compileParameterCurve(int slot, const SymbiosisParameterMapping& mapping) {
+	const int i = slot;
+	float steepness = 0.0f;
+	bool isPower = false;
+	float table[kMaxCurveTableSize];
+	int tableSize = 0;
+	if (mapping.curve != 0) {
+		const bool isValid = parseParameterCurve(mapping.curve, mapping.minValue, mapping.maxValue, steepness, isPower
+				, table, tableSize);
+		(void)isValid;
+		SY_ASSERT(isValid);
+	}
+	parameterCurves.minValues[i] = mapping.minValue;
+	parameterCurves.ranges[i] = mapping.maxValue - mapping.minValue;
+	parameterCurves.steepness[i] = steepness;
+	parameterCurves.isPower[i] = isPower;
+	parameterCurves.scales[i] = (isPower || steepness == 0.0f ? 1.0f : 1.0f / (expf(steepness) - 1.0f));
+	parameterCurves.offsets[i] = (isPower || steepness == 0.0f ? 0.0f : 1.0f);
+	parameterCurves.isQuantized[i] = (mapping.unit == kAudioUnitParameterUnit_Boolean
+			|| mapping.unit == kAudioUnitParameterUnit_Indexed);
+	if (tableSize > 0) {
+		if (parameterCurves.tableValueCount + tableSize > parameterCurves.tableValueCapacity) {
+			const int capacity = std::max(parameterCurves.tableValueCapacity * 2
+					, parameterCurves.tableValueCount + kMaxCurveTableSize);
+			float* tableValues = new float[capacity];
+			std::copy(parameterCurves.tableValues, parameterCurves.tableValues + parameterCurves.tableValueCount
+					, tableValues);
+			delete [] parameterCurves.tableValues;
+			parameterCurves.tableValues = tableValues;
+			parameterCurves.tableValueCapacity = capacity;
+		}
+		std::copy(table, table + tableSize, parameterCurves.tableValues + parameterCurves.tableValueCount);
+		parameterCurves.tableStarts[i] = parameterCurves.tableValueCount;
+		parameterCurves.tableSizes[i] = tableSize;
+		parameterCurves.tableValueCount += tableSize;
+	}
+}
+
+void SymbiosisComponent::releaseParameterSmoothers() {
+	delete [] parameterSmoothers.parameters;
+	delete [] parameterSmoothers.times;
+	delete [] parameterSmoothers.isExponential;
+	delete [] parameterSmoothers.coefficients;
+	delete [] parameterSmoothers.maxSteps;
+	delete [] parameterSmoothers.current;
+	delete [] parameterSmoothers.target;
+	delete [] parameterSmoothers.sent;
+	memset(&parameterSmoothers, 0, sizeof (parameterSmoothers));
+}
+
+/**
+	Calculates the per update coefficients of all smoothers from their times, the sample rate and rampControlFrames.
+	Also syncs the smoothers with the current VST parameter values. Must not be called while rendering.
+*/
+void SymbiosisComponent::updateParameterSmoothingRates() {
+	const double framesPerUpdate = rampControlFrames;
+	for (int i = 0; i < parameterSmoothers.count; ++i) {
+		const double timeInFrames = std::max(parameterSmoothers.times[i] * streamFormat.mSampleRate, 1.0);
+		if (parameterSmoothers.isExponential[i]) {
+			parameterSmoothers.coefficients[i] = static_cast<float>(1.0 - exp(-framesPerUpdate / timeInFrames));
+			parameterSmoothers.maxSteps[i] = 1.0f;
+		} else {
+			parameterSmoothers.coefficients[i] = 1.0f;
+			parameterSmoothers.maxSteps[i] = static_cast<float>(std::min(framesPerUpdate / timeInFrames, 1.0));
+		}
+		const float value = vst->getParameter(parameterSmoothers.parameters[i]);
+		parameterSmoothers.current[i] = value;
+		parameterSmoothers.target[i] = value;
+		parameterSmoothers.sent[i] = value;
+	}
+	smoothingActive = false;
+}
+
+/**
+	Sets \p parameter to \p value, through its smoother if smoothing is configured for the parameter (and the VST is
+	resumed). Called from the render thread only (while resumed).
+*/
+void SymbiosisComponent::setParameterSmoothed(int parameter, float value) {
+	SY_ASSERT(isMappedParameter(parameter));
+	const int i = parameterSmootherIndices[parameterSlots[parameter]];
+	if (i < 0 || !vst->isResumed()) {
+		vst->setParameter(parameter, value);
+		return;
+	}
+	if (parameterSmoothers.current[i] == parameterSmoothers.target[i]) {												// Idle, the parameter may have been changed by other means since.
+		const float currentValue = vst->getParameter(parameter);
+		parameterSmoothers.current[i] = currentValue;
+		parameterSmoothers.sent[i] = currentValue;
+	}
+	parameterSmoothers.target[i] = value;
+	if (!smoothingActive) {
+		smoothingActive = true;
+		lastSmoothingOffset = 0;
+	}
+}
+
+/**
+	Sets \p parameter to \p value right away, bypassing its smoother. Used for scheduled events, ramps and other writes
+	that must not be smoothed. A smoother in progress for the parameter is stopped at \p value so that it does not
+	override the write (and so that AudioUnitGetParameter() does not report its old target).
+*/
+void SymbiosisComponent::setParameterUnsmoothed(int parameter, float value) {
+	vst->setParameter(parameter, value);
+	const int i = (isMappedParameter(parameter) ? parameterSmootherIndices[parameterSlots[parameter]] : -1);
+	if (i >= 0) {
+		parameterSmoothers.current[i] = value;
+		parameterSmoothers.target[i] = value;
+		parameterSmoothers.sent[i] = value;
+	}
+}
+
+/**
+	Advances all smoothers to frame \p offset of the current slice and passes changed values to the VST. The first
+	loop has no branches or calls so that the compiler can vectorize it.
+*/
+void SymbiosisComponent::updateParameterSmoothers(int offset) {
+	const int elapsed = offset - lastSmoothingOffset;
+	if (elapsed <= 0) {
+		return;
+	}
+	lastSmoothingOffset = offset;
+	const float scale = static_cast<float>(elapsed) / static_cast<float>(rampControlFrames);
+	const int count = parameterSmoothers.count;
+	const float* coefficients = parameterSmoothers.coefficients;
+	const float* maxSteps = parameterSmoothers.maxSteps;
+	const float* target = parameterSmoothers.target;
+	float* current = parameterSmoothers.current;
+	for (int i = 0; i < count; ++i) {
+		const float maxStep = maxSteps[i] * scale;
+		const float step = std::max(-maxStep, std::min(maxStep, (target[i] - current[i])
+				* std::min(coefficients[i] * scale, 1.0f)));
+		const float next = current[i] + step;
+		current[i] = (fabsf(target[i] - next) < 1.0e-5f ? target[i] : next);
+	}
+	bool anyActive = false;
+	float* sent = parameterSmoothers.sent;
+	for (int i = 0; i < count; ++i) {
+		if (current[i] != sent[i]) {
+			vst->setParameter(parameterSmoothers.parameters[i], current[i]);
+			sent[i] = current[i];
+		}
+		anyActive = anyActive || (current[i] != target[i]);
+	}
+	smoothingActive = anyActive;
+}
+
+void SymbiosisComponent::finishParameterSmoothing() {
+	for (int i = 0; i < parameterSmoothers.count; ++i) {
+		if (parameterSmoothers.current[i] != parameterSmoothers.target[i]) {
+			vst->setParameter(parameterSmoothers.parameters[i], parameterSmoothers.target[i]);
+			parameterSmoothers.current[i] = parameterSmoothers.target[i];
+			parameterSmoothers.sent[i] = parameterSmoothers.target[i];
+		}
+	}
+	smoothingActive = false;
+}
+
+/**
+	Returns the (exclusive) end offset of the sub-block starting at \p offset. Events before the end offset are delivered
+	with the sub-block. While parameter ramps are active, sub-blocks are also limited to the ramp control rate (unless
+	fixedBlockSize is set). If neither applies the entire slice is rendered at once.
+*/
+int SymbiosisComponent::findSubBlockEnd(int offset, int frameCount, int midiIndex, int parameterIndex) const {
+	int endOffset = frameCount;
+	if ((activeRampCount > 0 || smoothingActive) && fixedBlockSize <= 0) {												// With a fixed block size, ramps and smoothers are only updated once per block.
+		endOffset = std::min(endOffset, offset + rampControlFrames);
+	}
+	if (subBlockMinFrames <= 0) {
+		return endOffset;
+	}
+	const int minEndOffset = offset + subBlockMinFrames;
+	for (int i = midiIndex; i < vstMidiEvents.numEvents; ++i) {
+		if (vstMidiEvents.events[i]->deltaFrames >= minEndOffset) {
+			endOffset = std::min(endOffset, static_cast<int>(vstMidiEvents.events[i]->deltaFrames));
+			break;
+		}
+	}
+	for (int i = parameterIndex; i < scheduledParameterCount; ++i) {
+		if (scheduledParameters[i].offset >= minEndOffset) {
+			endOffset = std::min(endOffset, scheduledParameters[i].offset);
+			break;
+		}
+	}
+	return endOffset;
+}
+
+/**
+	Returns true if processing can be skipped for this slice, i.e. if the input has been silent for longer than the
+	tail of the effect. The countdown is restarted whenever the input is not silent.
+*/
+bool SymbiosisComponent::updateSilenceCountdown(int frameCount, bool inputIsSilent) {
+	if (!inputIsSilent || inputBusCount == 0 || vstWantsMidi || silenceTailFrames < 0) {
+		silenceCountdown = std::max(silenceTailFrames, 0);
+		return false;
+	} else if (silenceCountdown > 0) {
+		silenceCountdown -= std::min(silenceCountdown, frameCount);
+		return false;
+	} else {
+		return true;
+	}
+}
+
+void SymbiosisComponent::processVST(const float* const* inputPointers, float* const* outputPointers, int frameCount) {
+	SY_ASSERT(vstSampleBytes == sizeof (float));
+	vst->processReplacing(inputPointers, outputPointers, frameCount);
+}
+
+void SymbiosisComponent::processVST(const double* const* inputPointers, double* const* outputPointers
+		, int frameCount) {
+	SY_ASSERT(vstSampleBytes == sizeof (double));
+	vst->processDoubleReplacing(inputPointers, outputPointers, frameCount);
+}
+
+/**
+	Moves the VST time info \p offset frames ahead of \p baseSamplePos and \p basePpqPos.
+*/
+void SymbiosisComponent::offsetVSTTimeInfo(double baseSamplePos, double basePpqPos, int offset) {
+	vstTimeInfo.samplePos = baseSamplePos + offset;
+	vstTimeInfo.ppqPos = basePpqPos;
+	if ((vstTimeInfo.flags & kVstPpqPosValid) != 0 && (vstTimeInfo.flags & kVstTempoValid) != 0) {
+		vstTimeInfo.ppqPos += offset * vstTimeInfo.tempo / (60.0 * vstTimeInfo.sampleRate);
+	}
+}
+
+/**
+	Processes \p frameCount frames together with all queued events up to \p frameCount. Later MIDI events are kept for
+	the next call (or the next render call) and their offsets are moved back by \p frameCount. The same goes for
+	scheduled parameter events if \p isLastChunk is false (i.e. render() is processing a large request in several
+	chunks), otherwise all remaining parameter events are applied.
+*/
+template<typename T> void SymbiosisComponent::renderOutput(int frameCount, const T* const* inputPointers
+		, T** outputPointers, bool inputIsSilent, bool isLastChunk) {
+	if (updateSilenceCountdown(frameCount, inputIsSilent)) {
+		SY_TRACE(SY_TRACE_FREQUENT, "Input silent and tail elapsed, skipping processing");
+		int parameterIndex = 0;
+		while (parameterIndex < scheduledParameterCount
+				&& (isLastChunk || scheduledParameters[parameterIndex].offset < frameCount)) {
+			setParameterUnsmoothed(scheduledParameters[parameterIndex].parameter
+					, scheduledParameters[parameterIndex].value);
+			++parameterIndex;
+		}
+		scheduledParameterCount -= parameterIndex;
+		for (int i = 0; i < scheduledParameterCount; ++i) {
+			scheduledParameters[i] = scheduledParameters[parameterIndex + i];
+			scheduledParameters[i].offset -= frameCount;
+		}
+		updateParameterRamps(frameCount);
+		for (int i = 0; i < activeRampCount; ++i) {
+			activeRamps[i].startOffset -= frameCount;
+		}
+		if (smoothingActive) {
+			updateParameterSmoothers(frameCount);
+		}
+		lastSmoothingOffset -= frameCount;
+		for (int i = 0; i < vst->getOutputCount(); ++i) {
+			memset(outputPointers[i], 0, sizeof (T) * frameCount);
+		}
+		silentOutput = true;
+		return;
+	}
+	
+	const double sliceSamplePos = vstTimeInfo.samplePos;
+	const double slicePpqPos = vstTimeInfo.ppqPos;
+	const T* subInputPointers[kMaxChannels];
+	T* subOutputPointers[kMaxChannels];
+	int midiIndex = 0;
+	int parameterIndex = 0;
+	bool allSilent = true;
+	int offset = 0;
+	while (offset < frameCount) {
+		const int endOffset = findSubBlockEnd(offset, frameCount, midiIndex, parameterIndex);
+		const bool takeAllEvents = (isLastChunk && endOffset >= frameCount);
+		const int subFrameCount = endOffset - offset;
+		SY_ASSERT(subFrameCount > 0);
+		
+		while (parameterIndex < scheduledParameterCount
+				&& (takeAllEvents || scheduledParameters[parameterIndex].offset < endOffset)) {
+			setParameterUnsmoothed(scheduledParameters[parameterIndex].parameter
+					, scheduledParameters[parameterIndex].value);
+			++parameterIndex;
+		}
+		updateParameterRamps(offset);
+		if (smoothingActive) {
+			updateParameterSmoothers(offset);
+		}
+
+		vstSubBlockEvents.numEvents = 0;
+		while (midiIndex < vstMidiEvents.numEvents
+				&& vstMidiEvents.events[midiIndex]->deltaFrames < endOffset) {
+			VstEvent* e = vstMidiEvents.events[midiIndex];
+			e->deltaFrames = std::max(0, std::min(static_cast<int>(e->deltaFrames) - offset, subFrameCount - 1));
+			vstSubBlockEvents.events[vstSubBlockEvents.numEvents] = e;
+			++vstSubBlockEvents.numEvents;
+			++midiIndex;
+		}
+		if (vstSubBlockEvents.numEvents > 0) {
+			vst->processEvents(*reinterpret_cast<const VstEvents*>(&vstSubBlockEvents));
+		}
+
+		for (int i = 0; i < vst->getInputCount(); ++i) {
+			subInputPointers[i] = inputPointers[i] + offset;
+		}
+		for (int i = 0; i < vst->getOutputCount(); ++i) {
+			subOutputPointers[i] = outputPointers[i] + offset;
+		}
+		if (offset != 0) {
+			offsetVSTTimeInfo(sliceSamplePos, slicePpqPos, offset);
+		}
+
+		if (vstGotSymbiosisExtensions) {
+			vst->vendorSpecific('sI00', inputIsSilent ? 1 : 0, 0, 0);
+		}
+		vstProcessOffset = renderBlockOffset + offset;
+		processVST(subInputPointers, subOutputPointers, subFrameCount);
+		if (vstGotSymbiosisExtensions) {
+		#if (!defined(NDEBUG))
+			bool reallyGotSignal = false;
+			for (int i = 0; i < vst->getOutputCount() && !reallyGotSignal; ++i) {
+				for (int j = 0; j < subFrameCount && !reallyGotSignal; ++j) {
+					reallyGotSignal = (subOutputPointers[i][j] != 0.0);
+				}
+			}
+		#endif
+			if (vst->vendorSpecific('sO00', 0, 0, 0)) {
+				SY_ASSERT0(!reallyGotSignal
+						, "SY vendor-specific callback 'sO00' returned true (output silent) when output was not silent");
+			} else {
+				allSilent = false;
+			#if (!defined(NDEBUG))
+				if (!reallyGotSignal) {
+					SY_TRACE(SY_TRACE_FREQUENT
+							, "SY vendor-specific callback 'sO00' returned false (not silent) when output was silent");
+				}
+			#endif
+			}
+		} else {
+			allSilent = false;
+		}
+		offset = endOffset;
+	}
+	SY_ASSERT(!isLastChunk || parameterIndex == scheduledParameterCount);
+	const int remainingMidiEvents = vstMidiEvents.numEvents - midiIndex;
+	bool sysExPending = false;
+	for (int i = 0; i < remainingMidiEvents; ++i) {																		// Swap (rather than copy) the event pointers to keep every preallocated event in the array.
+		VstEvent* e = vstMidiEvents.events[midiIndex + i];
+		vstMidiEvents.events[midiIndex + i] = vstMidiEvents.events[i];
+		vstMidiEvents.events[i] = e;
+		e->deltaFrames -= frameCount;
+		sysExPending = sysExPending || (e->type == kVstSysExType);
+	}
+	vstMidiEvents.numEvents = remainingMidiEvents;
+	if (!sysExPending) {
+		sysExArenaUsed = 0;
+	}
+	const int remainingParameterEvents = scheduledParameterCount - parameterIndex;
+	for (int i = 0; i < remainingParameterEvents; ++i) {
+		scheduledParameters[i] = scheduledParameters[parameterIndex + i];
+		scheduledParameters[i].offset -= frameCount;
+	}
+	scheduledParameterCount = remainingParameterEvents;
+	for (int i = 0; i < activeRampCount; ++i) {
+		activeRamps[i].startOffset -= frameCount;
+	}
+	lastSmoothingOffset -= frameCount;
+	vstTimeInfo.samplePos = sliceSamplePos;
+	vstTimeInfo.ppqPos = slicePpqPos;
+	silentOutput = allSilent;
+}
+
+/**
+	Renders \p frameCount frames through the fixed block size FIFOs. Input is collected until a full block of
+	fixedBlockSize frames is available, which is then rendered with renderOutput() while the output of the previous
+	block is played back. Event offsets are relative to the start of the block being collected. Parameter events that
+	fall beyond the last chunk of a render call are moved to the current FIFO position, MIDI events are kept for later.
+*/
+template<typename T> void SymbiosisComponent::renderThroughFIFOs(int frameCount, const T* const* inputPointers
+		, T** outputPointers, bool inputIsSilent, bool isLastChunk) {
+	SY_ASSERT(fixedBlockSize > 0);
+	const int chunkBlockOffset = renderBlockOffset;
+	const double chunkSamplePos = vstTimeInfo.samplePos;
+	const double chunkPpqPos = vstTimeInfo.ppqPos;
+	T* fifoInputs[kMaxChannels];
+	T* fifoOutputs[kMaxChannels];
+	for (int i = 0; i < vst->getInputCount(); ++i) {
+		fifoInputs[i] = reinterpret_cast<T*>(fifoInputBuffers[i]);
+	}
+	for (int i = 0; i < vst->getOutputCount(); ++i) {
+		fifoOutputs[i] = reinterpret_cast<T*>(fifoOutputBuffers[i]);
+	}
+	bool allSilent = true;
+	int offset = 0;
+	while (offset < frameCount) {
+		const int segmentFrames = std::min(frameCount - offset, fixedBlockSize - fifoFrames);
+		for (int i = 0; i < vst->getInputCount(); ++i) {																// Input is copied before output is written in case the buffers are aliased (in-place processing).
+			memcpy(fifoInputs[i] + fifoFrames, inputPointers[i] + offset, sizeof (T) * segmentFrames);
 		}
-		::AudioUnitRenderActionFlags inputFlags = 0;
-		if (renderCallbacks[inputBusIndex].inputProc != 0) {
-			throwOnOSError((*renderCallbacks[inputBusIndex].inputProc)(renderCallbacks[inputBusIndex].inputProcRefCon
-					, &inputFlags, timeStamp, inputBusIndex, frameCount
-					, reinterpret_cast< ::AudioBufferList* >(&bufferList)));
-		} else if (inputConnections[inputBusIndex].sourceAudioUnit != 0) {			
-			for (int i = 0; i < activeChannelCount; ++i) {
-				bufferList.mBuffers[i].mData = 0;
-			}
-			throwOnOSError(::AudioUnitRender(inputConnections[inputBusIndex].sourceAudioUnit, &inputFlags, timeStamp
-					, inputConnections[inputBusIndex].sourceOutputNumber, frameCount
-					, reinterpret_cast< ::AudioBufferList* >(&bufferList)));
-		} else {
-			for (int i = 0; i < activeChannelCount; ++i) {
-				memset(ioBuffers[ioChannelIndex + i], 0, sizeof (float) * frameCount);
-			}
-			inputFlags = kAudioUnitRenderAction_OutputIsSilence;
+		for (int i = 0; i < vst->getOutputCount(); ++i) {
+			memcpy(outputPointers[i] + offset, fifoOutputs[i] + fifoFrames, sizeof (T) * segmentFrames);
 		}
-		inputIsSilent = inputIsSilent && ((inputFlags & kAudioUnitRenderAction_OutputIsSilence) != 0);
-		for (int i = 0; i < maxChannelCount; ++i) {
-			inputPointers[ioChannelIndex + i]
-					= reinterpret_cast<float*>(bufferList.mBuffers[i % activeChannelCount].mData);
+		fifoInputSilent = fifoInputSilent && inputIsSilent;
+		allSilent = allSilent && fifoOutputSilent;
+		fifoFrames += segmentFrames;
+		offset += segmentFrames;
+		if (fifoFrames >= fixedBlockSize) {
+			offsetVSTTimeInfo(chunkSamplePos, chunkPpqPos, offset - fixedBlockSize);
+			renderBlockOffset = chunkBlockOffset + offset;																// The new block is played back from here on.
+			renderOutput<T>(fixedBlockSize, fifoInputs, fifoOutputs, fifoInputSilent, false);
+			fifoOutputSilent = silentOutput;
+			fifoInputSilent = true;
+			fifoFrames = 0;
 		}
-		ioChannelIndex += maxChannelCount;
 	}
-	SY_ASSERT(ioChannelIndex == vst->getInputCount());
-	
-#if (!defined(NDEBUG))
-	if (inputIsSilent) {
-		bool gotSignal = false;
-		for (int i = 0; i < vst->getInputCount() && !gotSignal; ++i) {
-			for (int j = 0; j < frameCount && !gotSignal; ++j) {
-				gotSignal = (inputPointers[i][j] != 0.0);
-			}
+	if (isLastChunk) {
+		for (int i = 0; i < scheduledParameterCount; ++i) {
+			scheduledParameters[i].offset = std::min(scheduledParameters[i].offset, fifoFrames);
 		}
-		SY_ASSERT0(!gotSignal, "Input was flagged silent when signal was not (may be bug in signal source)");
 	}
-#endif
-	
-	return inputIsSilent;
+	renderBlockOffset = chunkBlockOffset;
+	vstTimeInfo.samplePos = chunkSamplePos;
+	vstTimeInfo.ppqPos = chunkPpqPos;
+	silentOutput = allSilent;
 }
 
-void SymbiosisComponent::renderOutput(int frameCount, const float* const* inputPointers, float** outputPointers
-		, bool inputIsSilent) {
-	if (vstMidiEvents.numEvents > 0) {
-		vst->processEvents(*reinterpret_cast<const VstEvents*>(&vstMidiEvents));
-		vstMidiEvents.numEvents = 0;
+/**
+	Collects input and renders \p frameCount frames with the VST processing samples of type \p T. Requests larger than
+	maxFramesPerSlice (only accepted when rendering into the host's buffers) are rendered in chunks that fit our buffers
+	(and the VST's block size).
+*/
+template<typename T> ::OSStatus SymbiosisComponent::renderChunks(const ::AudioTimeStamp* inTimeStamp, int frameCount
+		, ::AudioBufferList* ioData, bool processInPlace) {
+	SY_ASSERT(sizeof (T) == vstSampleBytes);
+	SY_ASSERT(!renderedIntoHostBuffers || !needsSampleConversion());
+	const double baseSamplePos = vstTimeInfo.samplePos;
+	const double basePpqPos = vstTimeInfo.ppqPos;
+	::OSStatus status = noErr;
+	bool allSilent = true;
+	for (int chunkOffset = 0; chunkOffset < frameCount && status == noErr; chunkOffset += maxFramesPerSlice) {
+		const int chunkFrames = std::min(frameCount - chunkOffset, static_cast<int>(maxFramesPerSlice));
+		const bool isLastChunk = (chunkOffset + chunkFrames >= frameCount);
+		::AudioTimeStamp chunkTimeStamp = (*inTimeStamp);
+		if (chunkOffset != 0) {
+			chunkTimeStamp.mSampleTime += chunkOffset;
+			chunkTimeStamp.mFlags &= ~(kAudioTimeStampHostTimeValid | kAudioTimeStampWordClockTimeValid);
+			offsetVSTTimeInfo(baseSamplePos, basePpqPos, chunkOffset);
+		}
+		SymbiosisAudioBufferList chunkBuffers;
+		memset(&chunkBuffers, 0, sizeof (chunkBuffers));
+		if (renderedIntoHostBuffers) {
+			chunkBuffers.mNumberBuffers = ioData->mNumberBuffers;
+			for (int i = 0; i < static_cast<int>(ioData->mNumberBuffers); ++i) {
+				chunkBuffers.mBuffers[i].mNumberChannels = 1;
+				chunkBuffers.mBuffers[i].mDataByteSize = chunkFrames * sizeof (T);
+				chunkBuffers.mBuffers[i].mData = reinterpret_cast<T*>(ioData->mBuffers[i].mData) + chunkOffset;
+			}
+		}
+		T* inputPointers[kMaxChannels];
+		T* outputPointers[kMaxChannels];
+		bool inputIsSilent = true;
+		status = collectInputAudio<T>(chunkFrames, inputPointers, &chunkTimeStamp
+				, (processInPlace ? reinterpret_cast< ::AudioBufferList* >(&chunkBuffers) : 0), &inputIsSilent);
+		if (status == noErr) {
+			int ioChannelIndex = 0;
+			for (int outputBusIndex = 0; outputBusIndex < outputBusCount; ++outputBusIndex) {
+				int maxChannelCount = getMaxOutputChannels(outputBusIndex);
+				int activeChannelCount = getActiveOutputChannels(outputBusIndex);
+				for (int i = 0; i < maxChannelCount; ++i) {
+					if (renderedIntoHostBuffers) {
+						outputPointers[ioChannelIndex + i]
+								= reinterpret_cast<T*>(chunkBuffers.mBuffers[i % activeChannelCount].mData);
+					} else {
+						outputPointers[ioChannelIndex + i]
+								= reinterpret_cast<T*>(ioBuffers[ioChannelIndex + i % activeChannelCount]);
+					}
+				}
+				ioChannelIndex += maxChannelCount;
+			}
+			SY_ASSERT(ioChannelIndex == vst->getOutputCount());
+			renderBlockOffset = chunkOffset;
+			if (fixedBlockSize > 0) {
+				renderThroughFIFOs<T>(chunkFrames, inputPointers, outputPointers, inputIsSilent, isLastChunk);
+			} else {
+				renderOutput<T>(chunkFrames, inputPointers, outputPointers, inputIsSilent, isLastChunk);
+			}
+			allSilent = allSilent && silentOutput;
+		}
 	}
-	if (vstGotSymbiosisExtensions) {
-		vst->vendorSpecific('sI00', inputIsSilent ? 1 : 0, 0, 0);
+	vstTimeInfo.samplePos = baseSamplePos;
+	vstTimeInfo.ppqPos = basePpqPos;
+	silentOutput = allSilent;
+	return status;
+}
+
+/**
+	Converts the output of bus \p busNumber from ioBuffers into \p ioData in the stream format. If the host did not
+	supply buffers, ioData is pointed into the conversion buffer.
+*/
+void SymbiosisComponent::encodeOutput(int busNumber, int frameCount, ::AudioBufferList* ioData) {
+	const int firstChannel = outputBusChannelNumbers[busNumber];
+	const int activeChannelCount = getActiveOutputChannels(busNumber);
+	const int channelsPerBuffer = (streamIsInterleaved ? activeChannelCount : 1);
+	for (int i = 0; i < static_cast<int>(ioData->mNumberBuffers); ++i) {
+		SY_ASSERT(ioData->mBuffers[i].mData == 0
+				|| ioData->mBuffers[i].mDataByteSize == frameCount * streamSampleBytes * channelsPerBuffer);
+		if (ioData->mBuffers[i].mData == 0) {
+			ioData->mBuffers[i].mData = getConversionBuffer(firstChannel + i);
+		}
 	}
-	vst->processReplacing(inputPointers, outputPointers, frameCount);
-	if (vstGotSymbiosisExtensions) {
-	#if (!defined(NDEBUG))
-		bool reallyGotSignal = false;
-		for (int i = 0; i < vst->getOutputCount() && !reallyGotSignal; ++i) {
-			for (int j = 0; j < static_cast<int>(frameCount) && !reallyGotSignal; ++j) {
-				reallyGotSignal = (outputPointers[i][j] != 0.0);
-			}
+	if (streamIsInterleaved && streamSampleFormat == kFloat32Samples && activeChannelCount == 2
+			&& vstSampleBytes == sizeof (float)) {
+		interleaveStereo(ioBuffers[firstChannel], ioBuffers[firstChannel + 1]
+				, reinterpret_cast<float*>(ioData->mBuffers[0].mData), frameCount);
+		return;
+	}
+	for (int i = 0; i < activeChannelCount; ++i) {
+		unsigned char* destination = (streamIsInterleaved
+				? reinterpret_cast<unsigned char*>(ioData->mBuffers[0].mData) + i * streamSampleBytes
+				: reinterpret_cast<unsigned char*>(ioData->mBuffers[i].mData));
+		if (vstSampleBytes == sizeof (double)) {
+			encodeSamples(streamSampleFormat, reinterpret_cast<const double*>(ioBuffers[firstChannel + i]), destination
+					, channelsPerBuffer, frameCount);
+		} else {
+			encodeSamples(streamSampleFormat, ioBuffers[firstChannel + i], destination, channelsPerBuffer, frameCount);
 		}
-	#endif
-		if (vst->vendorSpecific('sO00', 0, 0, 0)) {
-			silentOutput = true;
-			SY_ASSERT0(!reallyGotSignal
-					, "SY vendor-specific callback 'sO00' returned true (output silent) when output was not silent");
+	}
+}
+
+/**
+	Passes the MIDI output that the VST has sent for the first \p frameCount frames of this render call to the host's
+	MIDI output callback (if any), as a packet list with time stamps in frames relative to \p inTimeStamp. Later events
+	(e.g. from a fixed block size VST that is ahead of the host) are kept for the next render call.
+*/
+void SymbiosisComponent::deliverMIDIOutput(const ::AudioTimeStamp* inTimeStamp, int frameCount) {
+	::MIDIPacketList* packetList = reinterpret_cast< ::MIDIPacketList* >(midiOutputPacketList);
+	packetList->numPackets = 0;
+	::MIDIPacket* packet = &packetList->packet[0];
+	int remainingEvents = 0;
+	for (int i = 0; i < midiOutputEventCount; ++i) {
+		const SymbiosisMIDIOutputEvent e = midiOutputEvents[i];
+		if (e.offset < frameCount) {
+			packet->timeStamp = e.offset;
+			packet->length = e.length;
+			memcpy(packet->data, e.data, e.length);
+			++packetList->numPackets;
+			packet = MIDIPacketNext(packet);
 		} else {
-			silentOutput = false;
-		#if (!defined(NDEBUG))
-			if (!reallyGotSignal) {
-				SY_TRACE(SY_TRACE_FREQUENT
-						, "SY vendor-specific callback 'sO00' returned false (not silent) when output was silent");
-			}
-		#endif
+			midiOutputEvents[remainingEvents] = e;
+			midiOutputEvents[remainingEvents].offset -= frameCount;
+			++remainingEvents;
 		}
-	} else {
-		silentOutput = false;
 	}
+	midiOutputEventCount = remainingEvents;
+	if (packetList->numPackets > 0 && midiOutputCallback.midiOutputCallback != 0) {
+		(*midiOutputCallback.midiOutputCallback)(midiOutputCallback.userData, inTimeStamp, 0, packetList);
+	}
+}
+
+/**
+	Records \p error as the last render error (unless an earlier error has not been read yet) and returns it.
+*/
+::OSStatus SymbiosisComponent::renderFailed(::OSStatus error) {
+	SY_ASSERT(error != noErr);
+	if (::OSAtomicCompareAndSwap32Barrier(noErr, error, &lastRenderError)) {
+		lastRenderErrorChanged = 1;
+	}
+	return error;
 }
 
-void SymbiosisComponent::render(::AudioUnitRenderActionFlags* ioActionFlags, const ::AudioTimeStamp* inTimeStamp
+/**
+	The render thread entry point. Everything called from here must report errors through return codes and never throw
+	or allocate memory.
+*/
+::OSStatus SymbiosisComponent::render(::AudioUnitRenderActionFlags* ioActionFlags, const ::AudioTimeStamp* inTimeStamp
 		, ::UInt32 inOutputBusNumber, ::UInt32 inNumberFrames, ::AudioBufferList* ioData) {
-	SY_TRACE2(SY_TRACE_FREQUENT, "Rendering %u channels on bus %u", static_cast<unsigned int>(ioData->mNumberBuffers)
-			, static_cast<unsigned int>(inOutputBusNumber));
 	if (ioData == 0 || inTimeStamp == 0) {
-		throw MacOSException(paramErr);
+		return renderFailed(paramErr);
 	}
+	SY_TRACE2(SY_TRACE_FREQUENT, "Rendering %u channels on bus %u", static_cast<unsigned int>(ioData->mNumberBuffers)
+			, static_cast<unsigned int>(inOutputBusNumber));
 	if (static_cast<int>(inOutputBusNumber) < 0 || static_cast<int>(inOutputBusNumber) >= outputBusCount) {
 		SY_TRACE1(1, "AURender called for an invalid bus (%u)", static_cast<unsigned int>(inOutputBusNumber));
-		throw MacOSException(paramErr);
+		return renderFailed(paramErr);
+	}
+	const int sampleBytes = streamSampleBytes;
+	bool hostBuffersUsable = (outputBusCount == 1 && !needsSampleConversion());											// With a single output bus there will be no further render calls for this time stamp, so we can render straight into the host's buffers (if it supplied any and no sample conversion is needed).
+	for (int i = 0; i < static_cast<int>(ioData->mNumberBuffers) && hostBuffersUsable; ++i) {
+		hostBuffersUsable = (ioData->mBuffers[i].mData != 0
+				&& ioData->mBuffers[i].mDataByteSize >= inNumberFrames * sampleBytes);
 	}
-	if (inNumberFrames > static_cast< ::UInt32 >(maxFramesPerSlice)) {
+	if (inNumberFrames > static_cast< ::UInt32 >(maxFramesPerSlice) && !hostBuffersUsable) {								// With host buffers we can render large requests in several chunks, otherwise our own buffers are too small.
 		SY_TRACE2(1, "AURender called for an unexpected large number of frames (expected max %d, got %u)"
 				, static_cast<int>(maxFramesPerSlice), static_cast<unsigned int>(inNumberFrames));
-		throw MacOSException(paramErr);
+		return renderFailed(kAudioUnitErr_TooManyFramesToProcess);
 	}
-	SY_ASSERT2(static_cast<int>(ioData->mNumberBuffers) == getActiveOutputChannels(inOutputBusNumber)
-			, "AURender called for an unexpected number of output channels (expected %d, got %u)"
-			, static_cast<int>(getActiveOutputChannels(inOutputBusNumber))
+	SY_ASSERT2(static_cast<int>(ioData->mNumberBuffers)
+			== (streamIsInterleaved ? 1 : getActiveOutputChannels(inOutputBusNumber))
+			, "AURender called for an unexpected number of output buffers (expected %d, got %u)"
+			, (streamIsInterleaved ? 1 : static_cast<int>(getActiveOutputChannels(inOutputBusNumber)))
 			, static_cast<unsigned int>(ioData->mNumberBuffers));
 
 	// --- Call pre-render notification callbacks
@@ -3882,38 +6330,82 @@ void SymbiosisComponent::render(::AudioUnitRenderActionFlags* ioActionFlags, con
 
 	// --- Collect input (for effects) and render output.
 	
-	if (lastRenderSampleTime != inTimeStamp->mSampleTime) {																// If lastRenderSampleTime == inTimeStamp->mSampleTime, the host is (probably) requesting another output bus for the current "batch".
+	::OSStatus status = noErr;
+	const bool renderedNow = (lastRenderSampleTime != inTimeStamp->mSampleTime);
+	if (renderedNow) {																									// If lastRenderSampleTime == inTimeStamp->mSampleTime, the host is (probably) requesting another output bus for the current "batch".
 		lastRenderSampleTime = inTimeStamp->mSampleTime;
-		updateVSTTimeInfo(inTimeStamp);
-		float* inputPointers[kMaxChannels];
-		float* outputPointers[kMaxChannels];
-		bool inputIsSilent = collectInputAudio(inNumberFrames, inputPointers, inTimeStamp);
-		int ioChannelIndex = 0;
-		for (int outputBusIndex = 0; outputBusIndex < outputBusCount; ++outputBusIndex) {
-			int maxChannelCount = getMaxOutputChannels(outputBusIndex);
-			int activeChannelCount = getActiveOutputChannels(outputBusIndex);
-			for (int i = 0; i < maxChannelCount; ++i) {
-				outputPointers[ioChannelIndex + i] = ioBuffers[ioChannelIndex + i % activeChannelCount];
+		renderThread = ::pthread_self();
+		renderInProgress = 1;
+		::OSMemoryBarrier();
+		if (stateLoadsPending != 0) {
+			SY_TRACE(SY_TRACE_FREQUENT, "VST state is being loaded, rendering silence");
+			renderedIntoHostBuffers = hostBuffersUsable;
+			if (renderedIntoHostBuffers) {
+				for (int i = 0; i < static_cast<int>(ioData->mNumberBuffers); ++i) {
+					memset(ioData->mBuffers[i].mData, 0, inNumberFrames * sampleBytes);
+				}
+			} else {
+				for (int i = 0; i < vst->getOutputCount(); ++i) {
+					memset(ioBuffers[i], 0, inNumberFrames * vstSampleBytes);
+				}
+			}
+			vstMidiEvents.numEvents = 0;																				// Events are timed relative to this slice, they would be stale by the next one.
+			sysExArenaUsed = 0;
+			scheduledParameterCount = 0;
+			silentOutput = true;
+		} else {
+			drainParameterQueue();
+			updateVSTTimeInfo(inTimeStamp);
+			renderedIntoHostBuffers = hostBuffersUsable;
+			const bool processInPlace = (renderedIntoHostBuffers && inPlaceProcessing && inputBusCount == 1
+					&& getMaxInputChannels(0) == getMaxOutputChannels(0)
+					&& getActiveInputChannels(0) == getActiveOutputChannels(0));
+			if (vstSampleBytes == sizeof (double)) {
+				status = renderChunks<double>(inTimeStamp, inNumberFrames, ioData, processInPlace);
+			} else {
+				status = renderChunks<float>(inTimeStamp, inNumberFrames, ioData, processInPlace);
+			}
+			if (status == noErr && midiOutputEventCount > 0) {
+				deliverMIDIOutput(inTimeStamp, inNumberFrames);
 			}
-			ioChannelIndex += maxChannelCount;
 		}
-		SY_ASSERT(ioChannelIndex == vst->getOutputCount());
-		renderOutput(inNumberFrames, inputPointers, outputPointers, inputIsSilent);
+		::OSMemoryBarrier();
+		renderInProgress = 0;
 	}
 
-	if (silentOutput) {
-		flags |= kAudioUnitRenderAction_OutputIsSilence;
+	if (status != noErr) {
+		lastRenderSampleTime = -12345678.0;																				// Pull input again if the host retries.
+		renderFailed(status);
+		flags |= kAudioUnitRenderAction_PostRenderError;
 	} else {
-		flags &= ~kAudioUnitRenderAction_OutputIsSilence;
-	}
-	for (int i = 0; i < static_cast<int>(ioData->mNumberBuffers); ++i) {
-		int ch = outputBusChannelNumbers[inOutputBusNumber] + i;
-		SY_ASSERT(ioBuffers[ch] != 0);
-		SY_ASSERT(ioData->mBuffers[i].mData == 0 || ioData->mBuffers[i].mDataByteSize == inNumberFrames * 4);
-		if (ioData->mBuffers[i].mData == 0) {
-			ioData->mBuffers[i].mData = ioBuffers[ch];
+		if (silentOutput) {
+			flags |= kAudioUnitRenderAction_OutputIsSilence;
+		} else {
+			flags &= ~kAudioUnitRenderAction_OutputIsSilence;
+		}
+		if (renderedIntoHostBuffers) {
+			if (!renderedNow) {
+				SY_TRACE(1, "AURender called repeatedly for the same time stamp on a single output bus, output is lost");
+				for (int i = 0; i < static_cast<int>(ioData->mNumberBuffers); ++i) {
+					SY_ASSERT(ioData->mBuffers[i].mData != 0);
+					memset(ioData->mBuffers[i].mData, 0, inNumberFrames * sampleBytes);
+				}
+				flags |= kAudioUnitRenderAction_OutputIsSilence;
+			}
+		} else if (needsSampleConversion()) {
+			encodeOutput(inOutputBusNumber, inNumberFrames, ioData);
 		} else {
-			memcpy(ioData->mBuffers[i].mData, ioBuffers[ch], inNumberFrames * 4);
+			for (int i = 0; i < static_cast<int>(ioData->mNumberBuffers); ++i) {
+				int ch = outputBusChannelNumbers[inOutputBusNumber] + i;
+				SY_ASSERT(ioBuffers[ch] != 0);
+				SY_ASSERT(ioData->mBuffers[i].mData == 0
+						|| ioData->mBuffers[i].mDataByteSize == inNumberFrames * sampleBytes);
+				if (ioData->mBuffers[i].mData == 0) {
+					ioData->mBuffers[i].mData = ioBuffers[ch];
+				} else {
+					memcpy(ioData->mBuffers[i].mData, ioBuffers[ch], inNumberFrames * sampleBytes);
+				}
+			}
 		}
 	}
 
@@ -3924,10 +6416,11 @@ void SymbiosisComponent::render(::AudioUnitRenderActionFlags* ioActionFlags, con
 		(*renderNotificationReceivers[i].inputProc)(renderNotificationReceivers[i].inputProcRefCon, &flags, inTimeStamp
 				, inOutputBusNumber, inNumberFrames, ioData);
 	}
-	flags &= ~kAudioUnitRenderAction_PostRender;
+	flags &= ~(kAudioUnitRenderAction_PostRender | kAudioUnitRenderAction_PostRenderError);
 	if (ioActionFlags != 0) {
 		(*ioActionFlags) = flags;
 	}
+	return status;
 }
 
 #if (SY_INCLUDE_GUI_SUPPORT)
@@ -4027,13 +6520,7 @@ void SymbiosisComponent::getProperty(::UInt32* ioDataSize, void* outData, ::Audi
 
 			case kAudioUnitProperty_ClassInfo: {
 				::CFMutableDictionaryRef& dictionaryRef = *reinterpret_cast< ::CFMutableDictionaryRef* >(outData);
-				if (presetIsFXB) {
-					dictionaryRef = createAUPresetOfCurrentBank(currentAUPreset.presetName);
-				} else {
-					dictionaryRef = createAUPresetOfCurrentProgram(currentAUPreset.presetName);
-				}
-				::SInt32 programNumber = vst->getCurrentProgram();
-				addIntToDictionary(dictionaryRef, CFSTR("ProgramNumber"), programNumber);
+				dictionaryRef = createClassInfo();
 				SY_ASSERT(::CFGetTypeID(dictionaryRef) == ::CFDictionaryGetTypeID());
 				SY_ASSERT(::CFPropertyListIsValid(dictionaryRef, kCFPropertyListXMLFormat_v1_0));
 				break;
@@ -4053,15 +6540,15 @@ void SymbiosisComponent::getProperty(::UInt32* ioDataSize, void* outData, ::Audi
 				break;
 			
 			case kAudioUnitProperty_ParameterInfo:
-				SY_ASSERT(0 <= static_cast<int>(inElement) && static_cast<int>(inElement) < vst->getParameterCount());
-				*reinterpret_cast< ::AudioUnitParameterInfo* >(outData) = parameterInfos[inElement];
+				SY_ASSERT(isMappedParameter(inElement));
+				*reinterpret_cast< ::AudioUnitParameterInfo* >(outData) = parameterInfos[parameterSlots[inElement]];
 				break;
 
 			case kAudioUnitProperty_ParameterValueStrings:
-				SY_ASSERT(0 <= static_cast<int>(inElement) && static_cast<int>(inElement) < vst->getParameterCount());
-				SY_ASSERT(parameterValueStrings[inElement] != 0);
-				*reinterpret_cast< ::CFArrayRef* >(outData) = parameterValueStrings[inElement];
-				::CFRetain(parameterValueStrings[inElement]);
+				SY_ASSERT(isMappedParameter(inElement));
+				SY_ASSERT(parameterValueStrings[parameterSlots[inElement]] != 0);
+				*reinterpret_cast< ::CFArrayRef* >(outData) = parameterValueStrings[parameterSlots[inElement]];
+				::CFRetain(parameterValueStrings[parameterSlots[inElement]]);
 				break;
 
 			case kAudioUnitProperty_StreamFormat:
@@ -4070,6 +6557,9 @@ void SymbiosisComponent::getProperty(::UInt32* ioDataSize, void* outData, ::Audi
 						? inputBusCount : outputBusCount));
 				streamFormat.mChannelsPerFrame = ((inScope == kAudioUnitScope_Input)
 						? getActiveInputChannels(inElement) : getActiveOutputChannels(inElement));
+				streamFormat.mBytesPerFrame = streamSampleBytes
+						* (streamIsInterleaved ? streamFormat.mChannelsPerFrame : 1);
+				streamFormat.mBytesPerPacket = streamFormat.mBytesPerFrame;
 				*reinterpret_cast< ::AudioStreamBasicDescription* >(outData) = streamFormat;
 				break;
 			
@@ -4106,7 +6596,20 @@ void SymbiosisComponent::getProperty(::UInt32* ioDataSize, void* outData, ::Audi
 				memcpy(outData, &hostCallbackInfo, (*ioDataSize));
 				break;
 
-			case kAudioUnitProperty_LastRenderError: *reinterpret_cast< ::OSStatus* >(outData) = noErr; break;
+			case kAudioUnitProperty_LastRenderError: {															// Reading the error also clears it.
+				::OSStatus error = noErr;
+				do {
+					error = lastRenderError;
+				} while (!::OSAtomicCompareAndSwap32Barrier(error, noErr, &lastRenderError));
+				*reinterpret_cast< ::OSStatus* >(outData) = error;
+				break;
+			}
+
+			case kAudioUnitProperty_MIDIOutputCallbackInfo: {
+				const void* outputName = CFSTR("MIDI Out");
+				*reinterpret_cast< ::CFArrayRef* >(outData) = ::CFArrayCreate(0, &outputName, 1, &kCFTypeArrayCallBacks);
+				break;
+			}
 
 			case kAudioUnitProperty_FactoryPresets:
 				SY_ASSERT(factoryPresetsArray != 0);
@@ -4160,37 +6663,64 @@ void SymbiosisComponent::getProperty(::UInt32* ioDataSize, void* outData, ::Audi
 				*reinterpret_cast< ::UInt32* >(outData) = (isBypassing ? 1 : 0);
 				break;
 
+			case kAudioUnitProperty_InPlaceProcessing:
+				*reinterpret_cast< ::UInt32* >(outData) = (inPlaceProcessing ? 1 : 0);
+				break;
+
 			case kAudioUnitProperty_ParameterStringFromValue: {
 				::AudioUnitParameterStringFromValue* sfv = reinterpret_cast< ::AudioUnitParameterStringFromValue* >
 						(outData);
-				if (static_cast<int>(sfv->inParamID) < 0 || static_cast<int>(sfv->inParamID)
-						>= vst->getParameterCount()) {
+				if (!isMappedParameter(sfv->inParamID)) {
 					throw MacOSException(kAudioUnitErr_InvalidParameter);
 				}
 				sfv->outString = 0;
 				
-				char buffer[24 + 1] = "?";																				// The VST spec says 8 characters max, but many VSTs don't care about that, so I say 24. :-)
-				if (sfv->inValue == 0) {
-					vst->getParameterDisplay(sfv->inParamID, buffer);
+				// Hosts with generic parameter views ask for every display string on every refresh, so we keep the
+				// last string per parameter and reuse it as long as neither the value nor the VST state has changed.
+				
+				const ::int32_t generation = vst->getParameterCacheGeneration();
+				const float vstValue = (sfv->inValue == 0 ? vst->getParameter(sfv->inParamID)
+						: scaleFromAUParameter(sfv->inParamID, (*sfv->inValue)));
+				const ::int32_t quantizedValue = static_cast< ::int32_t >(floorf(vstValue * kDisplayStringQuantization
+						+ 0.5f));
+				SymbiosisDisplayString& cached = displayStrings[parameterSlots[sfv->inParamID]];
+				++displayStringLookups;
+				if (cached.string != 0 && cached.generation == generation && cached.quantizedValue == quantizedValue) {
+					++displayStringHits;
+					::CFRetain(cached.string);
+					sfv->outString = cached.string;
 				} else {
-					SY_ASSERT(vstGotSymbiosisExtensions);
-					*reinterpret_cast<float*>(buffer) = scaleFromAUParameter(sfv->inParamID, (*sfv->inValue));
-					VstIntPtr vendorSpecificReturn = vst->vendorSpecific('sV2S', sfv->inParamID, buffer, 0);
-					if (vendorSpecificReturn == 0) {
-						SY_TRACE(1, "Warning! Symbiosis extension 'sV2S' (value to string conversion) returned 0");
-						throw MacOSException(kAudioUnitErr_InvalidProperty);
+					char buffer[24 + 1] = "?";																			// The VST spec says 8 characters max, but many VSTs don't care about that, so I say 24. :-)
+					if (sfv->inValue == 0) {
+						vst->getParameterDisplay(sfv->inParamID, buffer);
+					} else {
+						SY_ASSERT(vstGotSymbiosisExtensions);
+						*reinterpret_cast<float*>(buffer) = vstValue;
+						VstIntPtr vendorSpecificReturn = vst->vendorSpecific('sV2S', sfv->inParamID, buffer, 0);
+						if (vendorSpecificReturn == 0) {
+							SY_TRACE(1, "Warning! Symbiosis extension 'sV2S' (value to string conversion) returned 0");
+							throw MacOSException(kAudioUnitErr_InvalidProperty);
+						}
 					}
+					sfv->outString = ::CFStringCreateWithCString(0, eatSpace(buffer), kCFStringEncodingMacRoman);		// Many VSTs return spaces in front of the display value, we drop these, makes no sense on Mac
+					SY_ASSERT(sfv->outString != 0);
+					releaseCFRef((::CFTypeRef*)&cached.string);
+					::CFRetain(sfv->outString);
+					cached.string = sfv->outString;
+					cached.quantizedValue = quantizedValue;
+					cached.generation = generation;
+				}
+				if (displayStringLookups % kDisplayStringTraceInterval == 0) {
+					SY_TRACE3(SY_TRACE_MISC, "Display string cache: %u hits in %u lookups (%.1f%%)", displayStringHits
+							, displayStringLookups, 100.0 * displayStringHits / displayStringLookups);
 				}
-				sfv->outString = ::CFStringCreateWithCString(0, eatSpace(buffer), kCFStringEncodingMacRoman);			// Many VSTs return spaces in front of the display value, we drop these, makes no sense on Mac
-				SY_ASSERT(sfv->outString != 0);
 				break;
 			}
 			
 			case kAudioUnitProperty_ParameterValueFromString: {
 				::AudioUnitParameterValueFromString* vfs = reinterpret_cast< ::AudioUnitParameterValueFromString* >
 						(outData);
-				if (static_cast<int>(vfs->inParamID) < 0 || static_cast<int>(vfs->inParamID)
-						>= vst->getParameterCount()) {
+				if (!isMappedParameter(vfs->inParamID)) {
 					throw MacOSException(kAudioUnitErr_InvalidParameter);
 				}
 				vfs->outValue = 0.0f;
@@ -4248,7 +6778,7 @@ void SymbiosisComponent::getProperty(::UInt32* ioDataSize, void* outData, ::Audi
 }
 
 bool SymbiosisComponent::updateInitialDelayTime() {
-	int delaySamples = vst->getInitialDelay();
+	int delaySamples = vst->getInitialDelay() + fixedBlockSize;
 	double newInitialDelayTime = delaySamples / static_cast<double>(streamFormat.mSampleRate);
 	if (initialDelayTime != newInitialDelayTime) {
 		initialDelayTime = newInitialDelayTime;
@@ -4259,8 +6789,15 @@ bool SymbiosisComponent::updateInitialDelayTime() {
 }
 
 bool SymbiosisComponent::updateTailTime() {
+	int tailSamples = (vstSupportsTail ? vst->getTailSize() : 0);
+	if (vst->dontProcessSilence() || tailSamples == 1) {																// 1 = no tail
+		silenceTailFrames = vst->getInitialDelay();
+	} else if (tailSamples <= 0) {																						// 0 = variable / unknown tail
+		silenceTailFrames = -1;
+	} else {
+		silenceTailFrames = tailSamples + vst->getInitialDelay();
+	}
 	if (vstSupportsTail) {
-		int tailSamples = vst->getTailSize();
 		double newTailTime = tailSamples / static_cast<double>(streamFormat.mSampleRate);
 		if (tailTime != newTailTime) {
 			tailTime = newTailTime;
@@ -4298,12 +6835,43 @@ bool SymbiosisComponent::updateSampleRate(::Float64 newSampleRate) {
 	}
 }
 
+/**
+	All buses share the same sample format and layout, just like they share the sample rate. For interleaved streams
+	mBytesPerFrame and mBytesPerPacket depend on the channel count and are filled in per bus by getProperty().
+*/
+bool SymbiosisComponent::updateSampleFormat(SymbiosisSampleFormat newSampleFormat, bool newIsInterleaved) {
+	if (newSampleFormat != streamSampleFormat || newIsInterleaved != streamIsInterleaved) {
+		static const int kSampleBytes[] = { 4, 8, 2, 3, 4 };
+		streamSampleFormat = newSampleFormat;
+		streamSampleBytes = kSampleBytes[newSampleFormat];
+		streamIsInterleaved = newIsInterleaved;
+		streamFormat.mFormatFlags = ((newSampleFormat == kFloat32Samples || newSampleFormat == kFloat64Samples)
+				? kAudioFormatFlagIsFloat : kAudioFormatFlagIsSignedInteger) | kBigEndianPCMFlag | kAudioFormatFlagIsPacked
+				| (newIsInterleaved ? 0 : kAudioFormatFlagIsNonInterleaved);
+		streamFormat.mBitsPerChannel = streamSampleBytes * 8;
+		streamFormat.mBytesPerFrame = streamSampleBytes;
+		streamFormat.mBytesPerPacket = streamSampleBytes;
+		reallocateIOBuffers();
+		for (int i = 0; i < inputBusCount; ++i) {
+			propertyChanged(kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, i);
+		}
+		for (int i = 0; i < outputBusCount; ++i) {
+			propertyChanged(kAudioUnitProperty_StreamFormat, kAudioUnitScope_Output, i);
+		}
+		return true;
+	} else {
+		return false;
+	}
+}
+
 void SymbiosisComponent::updateMaxFramesPerSlice(int newFramesPerSlice) {
 	if (maxFramesPerSlice != newFramesPerSlice) {
 		maxFramesPerSlice = newFramesPerSlice;
 		reallocateIOBuffers();
 		propertyChanged(kAudioUnitProperty_MaximumFramesPerSlice, kAudioUnitScope_Global, 0);
-		vst->setBlockSize(maxFramesPerSlice);
+		if (fixedBlockSize <= 0) {
+			vst->setBlockSize(maxFramesPerSlice);
+		}
 	}
 }
 
@@ -4314,17 +6882,38 @@ void SymbiosisComponent::updateFormat(::AudioUnitScope scope, int busNumber
 			, static_cast<unsigned int>(format.mChannelsPerFrame));
 	int maxChannelCount = ((scope == kAudioUnitScope_Input)
 			? getMaxInputChannels(busNumber) : getMaxOutputChannels(busNumber));
-	if (format.mFormatID != kAudioFormatLinearPCM
+	const bool isInterleaved = ((format.mFormatFlags & kAudioFormatFlagIsNonInterleaved) == 0);
+	SymbiosisSampleFormat sampleFormat = kFloat32Samples;
+	bool supported = true;
+	if ((format.mFormatFlags & kLinearPCMFormatFlagIsFloat) != 0) {
+		switch (format.mBitsPerChannel) {
+			case 32: sampleFormat = kFloat32Samples; break;
+			case 64: sampleFormat = kFloat64Samples; break;
+			default: supported = false; break;
+		}
+	} else if ((format.mFormatFlags & kLinearPCMFormatFlagIsSignedInteger) != 0) {
+		switch (format.mBitsPerChannel) {
+			case 16: sampleFormat = kInt16Samples; break;
+			case 24: sampleFormat = kInt24Samples; break;
+			case 32: sampleFormat = kInt32Samples; break;
+			default: supported = false; break;
+		}
+	} else {
+		supported = false;
+	}
+	if (!supported
+			|| format.mFormatID != kAudioFormatLinearPCM
 			|| format.mFramesPerPacket != 1
 			|| format.mBytesPerPacket != format.mBytesPerFrame
-			|| (format.mFormatFlags & (kLinearPCMFormatFlagIsFloat | kBigEndianPCMFlag
-					| kAudioFormatFlagIsNonInterleaved)) != (kLinearPCMFormatFlagIsFloat | kBigEndianPCMFlag
-					| kAudioFormatFlagIsNonInterleaved)
-			|| format.mBitsPerChannel != 32
-			|| format.mBytesPerFrame != 4
-			|| format.mChannelsPerFrame == 0) {
+			|| (format.mFormatFlags & kLinearPCMFormatFlagIsBigEndian) != kBigEndianPCMFlag
+			|| format.mChannelsPerFrame == 0
+			|| format.mBytesPerFrame != format.mBitsPerChannel / 8 * (isInterleaved ? format.mChannelsPerFrame : 1)) {	// Only packed samples (24-bit samples in 3 bytes).
 		throw MacOSException(kAudioUnitErr_FormatNotSupported);
 	}
+	if ((sampleFormat != streamSampleFormat || isInterleaved != streamIsInterleaved) && vst->isResumed()) {
+		SY_TRACE(SY_TRACE_MISC, "Cannot change sample format while initialized");
+		throw MacOSException(kAudioUnitErr_Initialized);
+	}
 	if (static_cast<int>(format.mChannelsPerFrame) != maxChannelCount && !(format.mChannelsPerFrame == 1 &&
 			maxChannelCount == 2 && canDoMonoIO)) {
 		/*
@@ -4347,6 +6936,7 @@ void SymbiosisComponent::updateFormat(::AudioUnitScope scope, int busNumber
 	} else {
 		outputBusChannelCounts[busNumber] = format.mChannelsPerFrame;
 	}
+	updateSampleFormat(sampleFormat, isInterleaved);
 	updateSampleRate(format.mSampleRate);
 }
 
@@ -4371,61 +6961,69 @@ void SymbiosisComponent::setProperty(::UInt32 inDataSize, const void* inData, ::
 		default: SY_ASSERT(0); break;
 
 		case kAudioUnitProperty_ClassInfo: {
+			beginStateLoad();
 			try {
-				::CFDictionaryRef dictionary = *reinterpret_cast< const ::CFDictionaryRef* >(inData);
-				if (dictionary == 0 || ::CFGetTypeID(dictionary) != ::CFDictionaryGetTypeID()) {
-					throw FormatException("Invalid AUPreset format");
-				}
+				try {
+					::CFDictionaryRef dictionary = *reinterpret_cast< const ::CFDictionaryRef* >(inData);
+					if (dictionary == 0 || ::CFGetTypeID(dictionary) != ::CFDictionaryGetTypeID()) {
+						throw FormatException("Invalid AUPreset format");
+					}
 				
-                checkIntInDictionary(dictionary, CFSTR(kAUPresetVersionKey), 1);
-                checkIntInDictionary(dictionary, CFSTR(kAUPresetTypeKey), componentDescription->componentType);
-                checkIntInDictionary(dictionary, CFSTR(kAUPresetSubtypeKey), componentDescription->componentSubType);
-                checkIntInDictionary(dictionary, CFSTR(kAUPresetManufacturerKey), componentDescription->componentManufacturer);
-
-				{
-					::SInt32 useProgramNumber = 0;
-					::CFNumberRef numberRef = reinterpret_cast< ::CFNumberRef >(::CFDictionaryGetValue(dictionary
-							, CFSTR("ProgramNumber")));
-					if (numberRef != 0) {
-						if (::CFGetTypeID(numberRef) != ::CFNumberGetTypeID()) {
-							throw FormatException("Value in dictionary is not of expected type");
-						}
-						::SInt32 programNumber;
-						::CFNumberGetValue(numberRef, kCFNumberSInt32Type, &programNumber);
-						SY_TRACE1(SY_TRACE_MISC, "Requested program number: %d", static_cast<int>(programNumber));
-						if (0 <= programNumber && programNumber < vst->getProgramCount()) {
-							useProgramNumber = programNumber;
+	                checkIntInDictionary(dictionary, CFSTR(kAUPresetVersionKey), 1);
+	                checkIntInDictionary(dictionary, CFSTR(kAUPresetTypeKey), componentDescription->componentType);
+	                checkIntInDictionary(dictionary, CFSTR(kAUPresetSubtypeKey), componentDescription->componentSubType);
+	                checkIntInDictionary(dictionary, CFSTR(kAUPresetManufacturerKey), componentDescription->componentManufacturer);
+
+					{
+						::SInt32 useProgramNumber = 0;
+						::CFNumberRef numberRef = reinterpret_cast< ::CFNumberRef >(::CFDictionaryGetValue(dictionary
+								, CFSTR("ProgramNumber")));
+						if (numberRef != 0) {
+							if (::CFGetTypeID(numberRef) != ::CFNumberGetTypeID()) {
+								throw FormatException("Value in dictionary is not of expected type");
+							}
+							::SInt32 programNumber;
+							::CFNumberGetValue(numberRef, kCFNumberSInt32Type, &programNumber);
+							SY_TRACE1(SY_TRACE_MISC, "Requested program number: %d", static_cast<int>(programNumber));
+							if (0 <= programNumber && programNumber < vst->getProgramCount()) {
+								useProgramNumber = programNumber;
+							}
 						}
+						vst->setCurrentProgram(useProgramNumber);
+					}
+					::CFStringRef nameRef = reinterpret_cast< ::CFStringRef >(getValueOfKeyInDictionary(dictionary
+							, CFSTR(kAUPresetNameKey), ::CFStringGetTypeID()));
+					::CFDataRef dataRef = reinterpret_cast< ::CFDataRef >(getValueOfKeyInDictionary(dictionary
+							, CFSTR(kAUPresetVSTDataKey), ::CFDataGetTypeID()));
+					SY_ASSERT(dataRef != 0);
+					SY_ASSERT(::CFGetTypeID(dataRef) == ::CFDataGetTypeID());
+					bool loadedPerfectly = vst->loadFXPOrFXB(::CFDataGetLength(dataRef), ::CFDataGetBytePtr(dataRef));
+					if (!loadedPerfectly) {
+						SY_TRACE(SY_TRACE_MISC, "Warning, FXP / FXB may not have loaded perfectly");
 					}
-					vst->setCurrentProgram(useProgramNumber);
+				
+					if (updateNameOnLoad) {
+						updateCurrentVSTProgramName(nameRef);
+					}
+					updateCurrentAUPreset();
+					currentAUPreset.presetNumber = -1;
+					propertyChanged(kAudioUnitProperty_CurrentPreset, kAudioUnitScope_Global, 0);
+					propertyChanged(kAudioUnitProperty_PresentPreset, kAudioUnitScope_Global, 0);
 				}
-				::CFStringRef nameRef = reinterpret_cast< ::CFStringRef >(getValueOfKeyInDictionary(dictionary
-						, CFSTR(kAUPresetNameKey), ::CFStringGetTypeID()));
-				::CFDataRef dataRef = reinterpret_cast< ::CFDataRef >(getValueOfKeyInDictionary(dictionary
-						, CFSTR(kAUPresetVSTDataKey), ::CFDataGetTypeID()));
-				SY_ASSERT(dataRef != 0);
-				SY_ASSERT(::CFGetTypeID(dataRef) == ::CFDataGetTypeID());
-				bool loadedPerfectly = vst->loadFXPOrFXB(::CFDataGetLength(dataRef), ::CFDataGetBytePtr(dataRef));
-				if (!loadedPerfectly) {
-					SY_TRACE(SY_TRACE_MISC, "Warning, FXP / FXB may not have loaded perfectly");
+				catch (const EOFException& x) {
+					SY_TRACE1(SY_TRACE_EXCEPTIONS, "Failed reading AUPreset, caught end of file exception: %s", x.what());
+					throw MacOSException(kAudioUnitErr_InvalidPropertyValue);
 				}
-				
-				if (updateNameOnLoad) {
-					updateCurrentVSTProgramName(nameRef);
+				catch (const FormatException& x) {
+					SY_TRACE1(SY_TRACE_EXCEPTIONS, "Failed reading AUPreset, caught format exception: %s", x.what());
+					throw MacOSException(kAudioUnitErr_InvalidPropertyValue);
 				}
-				updateCurrentAUPreset();
-				currentAUPreset.presetNumber = -1;
-				propertyChanged(kAudioUnitProperty_CurrentPreset, kAudioUnitScope_Global, 0);
-				propertyChanged(kAudioUnitProperty_PresentPreset, kAudioUnitScope_Global, 0);
-			}
-			catch (const EOFException& x) {
-				SY_TRACE1(SY_TRACE_EXCEPTIONS, "Failed reading AUPreset, caught end of file exception: %s", x.what());
-				throw MacOSException(kAudioUnitErr_InvalidPropertyValue);
 			}
-			catch (const FormatException& x) {
-				SY_TRACE1(SY_TRACE_EXCEPTIONS, "Failed reading AUPreset, caught format exception: %s", x.what());
-				throw MacOSException(kAudioUnitErr_InvalidPropertyValue);
+			catch (...) {
+				endStateLoad();
+				throw;
 			}
+			endStateLoad();
 			break;
 		}
 
@@ -4510,6 +7108,10 @@ void SymbiosisComponent::setProperty(::UInt32 inDataSize, const void* inData, ::
 			break;
 		}
 
+		case kAudioUnitProperty_MIDIOutputCallback:
+			midiOutputCallback = *reinterpret_cast< const ::AUMIDIOutputCallbackStruct* >(inData);
+			break;
+
 		case kAudioUnitProperty_CurrentPreset:
 		case kAudioUnitProperty_PresentPreset: {
 			::AUPreset requestedPreset;
@@ -4537,13 +7139,23 @@ void SymbiosisComponent::setProperty(::UInt32 inDataSize, const void* inData, ::
 					::CFDataRef dataRef = factoryPresetData[requestedPreset.presetNumber];
 					SY_ASSERT(dataRef != 0);
 					SY_ASSERT(::CFGetTypeID(dataRef) == ::CFDataGetTypeID());
-					bool loadedPerfectly = vst->loadFXPOrFXB(::CFDataGetLength(dataRef), ::CFDataGetBytePtr(dataRef));
+					beginStateLoad();
+					bool loadedPerfectly;
+					try {
+						loadedPerfectly = vst->loadFXPOrFXB(::CFDataGetLength(dataRef), ::CFDataGetBytePtr(dataRef));
+					}
+					catch (...) {
+						endStateLoad();
+						throw;
+					}
+					endStateLoad();
 					if (!loadedPerfectly) {
 						SY_TRACE(SY_TRACE_MISC, "Warning, FXP / FXB may not have loaded perfectly");
 					}
 					::CFRetain(factoryPresets[requestedPreset.presetNumber].presetName);
 					releaseCFRef((::CFTypeRef*)&currentAUPreset.presetName);
 					currentAUPreset = factoryPresets[requestedPreset.presetNumber];
+					currentVSTProgramNameValid = false;
 					propertyChanged(kAudioUnitProperty_CurrentPreset, kAudioUnitScope_Global, 0);
 					propertyChanged(kAudioUnitProperty_PresentPreset, kAudioUnitScope_Global, 0);
 				}
@@ -4559,20 +7171,223 @@ void SymbiosisComponent::setProperty(::UInt32 inDataSize, const void* inData, ::
 			SY_ASSERT0(success, "Could not set or reset VST bypass state");
 			break;
 		}
+
+		case kAudioUnitProperty_InPlaceProcessing: {
+			inPlaceProcessing = vstCanProcessInPlace && (*reinterpret_cast< const ::UInt32* >(inData) != 0);
+			SY_TRACE1(SY_TRACE_AU, "AU In-place processing %s", (inPlaceProcessing ? "on" : "off"));
+			break;
+		}
+	}
+}
+
+/**
+	Applies all parameter changes queued by AudioUnitSetParameter(). Called from the render thread only.
+*/
+void SymbiosisComponent::drainParameterQueue() {
+	int parameter;
+	float value;
+	while (parameterQueue.pop(parameter, value)) {
+		setParameterSmoothed(parameter, value);
+		::OSAtomicDecrement32Barrier(&pendingParameterWrites[parameterSlots[parameter]]);
+	}
+}
+
+/**
+	Waits for any render call in progress to finish and makes further render calls output silence (without calling the
+	VST) until endStateLoad(). This way the VST state can be replaced from a non-render thread without racing with
+	processReplacing(), and without the render thread ever having to wait for a lock.
+*/
+void SymbiosisComponent::beginStateLoad() {
+	::OSAtomicIncrement32Barrier(&stateLoadsPending);
+	while (renderInProgress != 0) {
+		::usleep(100);
+	}
+	::OSMemoryBarrier();
+	int parameter;
+	float value;
+	while (parameterQueue.pop(parameter, value)) {																		// Discard parameter changes queued before the load, the loaded state wins.
+		::OSAtomicDecrement32Barrier(&pendingParameterWrites[parameterSlots[parameter]]);
+	}
+	for (int i = 0; i < parameterSmoothers.count; ++i) {																// Stop smoothing so that we don't override the new state.
+		parameterSmoothers.target[i] = parameterSmoothers.current[i];
+	}
+	smoothingActive = false;
+}
+
+void SymbiosisComponent::endStateLoad() {
+	::OSAtomicDecrement32Barrier(&stateLoadsPending);
+}
+
+/**
+	Returns a key identifying the controller that \p e changes, or -1 if the event is not a continuous controller type
+	(i.e. control change, polyphonic or channel pressure or pitch bend) and must never be coalesced.
+*/
+static int getCoalescingKey(const VstMidiEvent& e) {
+	if (e.type != kVstMidiType) {
+		return -1;
+	}
+	const int status = static_cast<unsigned char>(e.midiData[0]);
+	switch (status & 0xF0) {
+		case 0xA0: case 0xB0: return ((status & 0x10) << 7) | ((status & 0x0F) << 7) | (e.midiData[1] & 0x7F);			// 0..4095
+		case 0xD0: case 0xE0: return 4096 + ((status & 0x10) | (status & 0x0F));										// 4096..4127
+		default: return -1;
+	}
+}
+
+/**
+	Makes room for an incoming MIDI event when vstMidiEvents is full. If the new event is a continuous controller that
+	is already pending, the pending event takes on the new value and true is returned (nothing more to insert).
+	Otherwise pending controller events that are superseded by later events for the same controller are removed. Called
+	on the render thread, so it must not allocate.
+*/
+bool SymbiosisComponent::coalesceMIDIEvents(const VstMidiEvent& incoming) {
+	const int incomingKey = getCoalescingKey(incoming);
+	if (incomingKey >= 0) {
+		for (int i = vstMidiEvents.numEvents - 1; i >= 0; --i) {
+			VstMidiEvent* e = reinterpret_cast<VstMidiEvent*>(vstMidiEvents.events[i]);
+			if (getCoalescingKey(*e) == incomingKey) {
+				e->midiData[1] = incoming.midiData[1];
+				e->midiData[2] = incoming.midiData[2];
+				return true;
+			}
+		}
+	}
+	::UInt32 seenKeys[(4096 + 32) / 32];
+	memset(seenKeys, 0, sizeof (seenKeys));
+	int kept = vstMidiEvents.numEvents;
+	for (int i = vstMidiEvents.numEvents - 1; i >= 0; --i) {															// Newest to oldest, moving superseded events to the (free) end of the array.
+		VstEvent* e = vstMidiEvents.events[i];
+		const int key = getCoalescingKey(*reinterpret_cast<VstMidiEvent*>(e));
+		if (key >= 0 && (seenKeys[key >> 5] & (1U << (key & 31))) != 0) {
+			--kept;
+			for (int j = i; j < kept; ++j) {
+				vstMidiEvents.events[j] = vstMidiEvents.events[j + 1];
+			}
+			vstMidiEvents.events[kept] = e;
+		} else if (key >= 0) {
+			seenKeys[key >> 5] |= (1U << (key & 31));
+		}
+	}
+	SY_TRACE1(SY_TRACE_FREQUENT, "MIDI event queue full, coalesced %d controller events"
+			, static_cast<int>(vstMidiEvents.numEvents - kept));
+	vstMidiEvents.numEvents = kept;
+	return false;
+}
+
+/**
+	Sets parameter \p parameterIndex to \p value (in the VST 0 to 1 range) at frame \p offset of the next slice (or
+	immediately if the VST is not resumed or the schedule is full).
+*/
+void SymbiosisComponent::scheduleParameter(int offset, int parameterIndex, float value) {
+	if (!vst->isResumed() || scheduledParameterCount >= kMaxScheduledParameterEvents) {
+		setParameterUnsmoothed(parameterIndex, value);
+		return;
 	}
+	int j = scheduledParameterCount;
+	while (j > 0 && scheduledParameters[j - 1].offset > offset) {														// Insertion sort, keeps events with equal offsets in order.
+		scheduledParameters[j] = scheduledParameters[j - 1];
+		--j;
+	}
+	scheduledParameters[j].offset = offset;
+	scheduledParameters[j].parameter = parameterIndex;
+	scheduledParameters[j].value = value;
+	++scheduledParameterCount;
 }
 
+/**
+	Queues a MIDI event for the VST. Events are kept sorted on offset and carried over to later render calls if the
+	offset is beyond the current slice. When the queue is full, controller events are coalesced (see
+	coalesceMIDIEvents()) and if that does not make room the event is dropped rather than failing the call.
+*/
 void SymbiosisComponent::midiInput(int offset, int status, int data1, int data2) {
+	if ((status & 0xF0) == 0xB0) {
+		const int parameterIndex = midiMap[(status & 0x0F) * 128 + (data1 & 0x7F)];
+		if (parameterIndex >= 0) {																						// Mapped in SYMIDIMap.txt, convert through the AU range and do not pass on to the VST.
+			const ::AudioUnitParameterInfo& parameterInfo = parameterInfos[parameterSlots[parameterIndex]];
+			float auValue = parameterInfo.minValue + (data2 & 0x7F) * (parameterInfo.maxValue - parameterInfo.minValue)
+					/ 127.0f;
+			if (parameterInfo.unit == kAudioUnitParameterUnit_Boolean
+					|| parameterInfo.unit == kAudioUnitParameterUnit_Indexed) {
+				auValue = floorf(auValue + 0.5f);
+			}
+			scheduleParameter(offset + fifoFrames, parameterIndex, scaleFromAUParameter(parameterIndex, auValue));
+			return;
+		}
+	}
 	if (vstWantsMidi) {
-		SY_ASSERT0(vstMidiEvents.numEvents < kMaxVSTMIDIEvents, "Too many MIDI events received");
-		if (vstMidiEvents.numEvents >= kMaxVSTMIDIEvents) throw MacOSException(memFullErr);
+		if (vstMidiEvents.numEvents >= kMaxVSTMIDIEvents) {
+			VstMidiEvent incoming;
+			memset(&incoming, 0, sizeof (incoming));
+			incoming.type = kVstMidiType;
+			incoming.byteSize = 24;
+			incoming.midiData[0] = status;
+			incoming.midiData[1] = data1;
+			incoming.midiData[2] = data2;
+			if (coalesceMIDIEvents(incoming)) {
+				return;
+			}
+			if (vstMidiEvents.numEvents >= kMaxVSTMIDIEvents) {
+				SY_TRACE3(1, "MIDI event queue full, dropping event %02X %02X %02X", status, data1, data2);
+				return;
+			}
+		}
 		VstMidiEvent* e = reinterpret_cast<VstMidiEvent*>(vstMidiEvents.events[vstMidiEvents.numEvents]);
-		e->deltaFrames = offset;
+		memset(e, 0, sizeof (VstMidiEvent));																			// The slot may have held a SysEx event.
+		e->type = kVstMidiType;
+		e->byteSize = 24;
 		e->midiData[0] = status;
 		e->midiData[1] = data1;
 		e->midiData[2] = data2;
-		++vstMidiEvents.numEvents;
+		queueVSTEvent(offset);
+	}
+}
+
+/**
+	Queues a SysEx dump for the VST. The data is copied into sysExArena (so no allocation takes place) and stays there
+	until every queued SysEx event has been delivered. Dumps larger than kSysExArenaSize are rejected with
+	kAudio_ParamError, and a dump that does not fit in the remaining space (or event queue) is rejected with memFullErr
+	(the host may send it again after the next render call).
+*/
+void SymbiosisComponent::sysExInput(int offset, const ::UInt8* data, int length) {
+	if (vstWantsMidi) {
+		if (data == 0 || length <= 0 || length > kSysExArenaSize) {
+			SY_TRACE1(SY_TRACE_MISC, "Rejecting SysEx dump of %d bytes", length);
+			throw MacOSException(kAudio_ParamError);
+		}
+		if (vstMidiEvents.numEvents >= kMaxVSTMIDIEvents || length > kSysExArenaSize - sysExArenaUsed) {
+			SY_TRACE2(SY_TRACE_MISC, "No room for SysEx dump of %d bytes (%d bytes queued)", length, sysExArenaUsed);
+			throw MacOSException(memFullErr);
+		}
+		SY_ASSERT(sysExArena != 0);
+		unsigned char* dump = sysExArena + sysExArenaUsed;
+		memcpy(dump, data, length);
+		sysExArenaUsed += length;
+		VstMidiSysexEvent* e = reinterpret_cast<VstMidiSysexEvent*>(vstMidiEvents.events[vstMidiEvents.numEvents]);
+		memset(e, 0, sizeof (VstMidiSysexEvent));
+		e->type = kVstSysExType;
+		e->byteSize = sizeof (VstMidiSysexEvent);
+		e->dumpBytes = length;
+		e->sysexDump = reinterpret_cast<char*>(dump);
+		queueVSTEvent(offset);
+	}
+}
+
+/**
+	Inserts the event at vstMidiEvents.events[vstMidiEvents.numEvents] (already filled in, except for deltaFrames) in
+	the queue, keeping the queue sorted on offset.
+*/
+void SymbiosisComponent::queueVSTEvent(int offset) {
+	SY_ASSERT(vstMidiEvents.numEvents < kMaxVSTMIDIEvents);
+	int i = vstMidiEvents.numEvents;
+	VstEvent* e = vstMidiEvents.events[i];
+	offset += fifoFrames;																								// Offsets are relative to the start of the block being collected (fifoFrames is always 0 unless fixedBlockSize > 0).
+	e->deltaFrames = offset;
+	while (i > 0 && vstMidiEvents.events[i - 1]->deltaFrames > offset) {												// Insertion sort (events usually arrive in order so this loop is rarely entered).
+		vstMidiEvents.events[i] = vstMidiEvents.events[i - 1];
+		--i;
 	}
+	vstMidiEvents.events[i] = e;
+	++vstMidiEvents.numEvents;
 }
 
 
@@ -4582,6 +7397,14 @@ void SymbiosisComponent::AudioUnitInitialize()
 {
 	SY_TRACE(SY_TRACE_AU, "AU kAudioUnitInitializeSelect");
 	if (!vst->isResumed()) {
+		vstSampleBytes = sizeof (float);
+		if (vst->canProcessDoubleReplacing()) {
+			if (streamSampleFormat == kFloat64Samples) {
+				vstSampleBytes = sizeof (double);
+			}
+			vst->setProcessPrecision(vstSampleBytes == sizeof (double));												// Many VSTs return false here although they support double precision, so the result is ignored.
+		}
+		updateParameterSmoothingRates();
 		vst->resume();
 		updateInitialDelayAndTailTimes();
 		vstWantsMidi = vst->wantsMidi();
@@ -4591,6 +7414,13 @@ void SymbiosisComponent::AudioUnitInitialize()
 void SymbiosisComponent::AudioUnitUninitialize()
 {
 	SY_TRACE(SY_TRACE_AU, "AU kAudioUnitUninitializeSelect");
+	drainParameterQueue();
+	for (int i = 0; i < scheduledParameterCount; ++i) {
+		setParameterUnsmoothed(scheduledParameters[i].parameter, scheduledParameters[i].value);
+	}
+	scheduledParameterCount = 0;
+	finishParameterRamps();
+	finishParameterSmoothing();
 	if (vst->isResumed()) {
 		vst->suspend();
 	}
@@ -4637,7 +7467,12 @@ void SymbiosisComponent::AudioUnitAddPropertyListener(AudioUnitPropertyID pinID,
 	listener.fPropertyID = pinID;
 	listener.fListenerProc = pinProc;
 	listener.fListenerRefCon = pinProcRefCon;
-	propertyListeners[propertyListenersCount] = listener;
+	int i = propertyListenersCount;
+	while (i > 0 && propertyListeners[i - 1].fPropertyID > pinID) {
+		propertyListeners[i] = propertyListeners[i - 1];
+		--i;
+	}
+	propertyListeners[i] = listener;
 	++propertyListenersCount;
 	SY_TRACE3(SY_TRACE_AU, "AU Added listener %p (refcon: %p) on property: %d", pinProc, pinProcRefCon
 			, static_cast<int>(pinID));
@@ -4694,9 +7529,18 @@ void SymbiosisComponent::AudioUnitGetParameter(AudioUnitParameterID pinID,
 			, static_cast<int>(pinScope));
 	SY_ASSERT(poutValue != 0);
 	if (pinScope != kAudioUnitScope_Global) throw MacOSException(kAudioUnitErr_InvalidScope);
-	if (static_cast<int>(pinID) < 0 || static_cast<int>(pinID) >= vst->getParameterCount())
-		throw MacOSException(kAudioUnitErr_InvalidParameter);
-	(*poutValue) = scaleToAUParameter(pinID, vst->getParameter(pinID));
+	if (!isMappedParameter(pinID)) throw MacOSException(kAudioUnitErr_InvalidParameter);
+	const int slot = parameterSlots[pinID];
+	const int i = parameterSmootherIndices[slot];
+	float value;
+	if (pendingParameterWrites[slot] > 0) {
+		value = pendingParameterValues[slot];
+	} else if (i >= 0 && parameterSmoothers.current[i] != parameterSmoothers.target[i]) {								// Report the value the host set, not the intermediate values of the smoother.
+		value = parameterSmoothers.target[i];
+	} else {
+		value = vst->getParameter(pinID);
+	}
+	(*poutValue) = scaleToAUParameter(pinID, value);
 }
 		
 void SymbiosisComponent::AudioUnitSetParameter(AudioUnitParameterID pinID,
@@ -4710,9 +7554,19 @@ void SymbiosisComponent::AudioUnitSetParameter(AudioUnitParameterID pinID,
 	SY_TRACE4(SY_TRACE_FREQUENT, "AU Set parameter: %d, %d, %f, %d", static_cast<int>(pinID)
 			, static_cast<int>(pinScope), pinValue, static_cast<int>(pinBufferOffsetInFrames));
 	if (pinScope != kAudioUnitScope_Global) throw MacOSException(kAudioUnitErr_InvalidScope);
-	if (static_cast<int>(pinID) < 0 || static_cast<int>(pinID) >= vst->getParameterCount())
-		throw MacOSException(kAudioUnitErr_InvalidParameter);
-	vst->setParameter(pinID, scaleFromAUParameter(pinID, pinValue));
+	if (!isMappedParameter(pinID)) throw MacOSException(kAudioUnitErr_InvalidParameter);
+	const float value = scaleFromAUParameter(pinID, pinValue);
+	if (vst->isResumed()) {																								// Initialized, so the render thread may be running. Leave it to the render thread to apply the change.
+		const int slot = parameterSlots[pinID];
+		pendingParameterValues[slot] = value;
+		::OSAtomicIncrement32Barrier(&pendingParameterWrites[slot]);
+		if (parameterQueue.push(pinID, value)) {
+			return;
+		}
+		::OSAtomicDecrement32Barrier(&pendingParameterWrites[slot]);
+		SY_TRACE(SY_TRACE_AU, "Parameter queue full, setting parameter directly");
+	}
+	vst->setParameter(pinID, value);
 }
 		
 void SymbiosisComponent::AudioUnitReset(AudioUnitScope pinScope, AudioUnitElement pinElement)
@@ -4720,6 +7574,8 @@ void SymbiosisComponent::AudioUnitReset(AudioUnitScope pinScope, AudioUnitElemen
 	SY_TRACE(SY_TRACE_AU, "AU kAudioUnitResetSelect");
 
 	if (pinScope != kAudioUnitScope_Global) throw MacOSException(kAudioUnitErr_InvalidScope);
+	finishParameterRamps();
+	finishParameterSmoothing();
 	if (vst->isResumed()) {
 		vst->suspend();
 		vst->resume();
@@ -4727,6 +7583,9 @@ void SymbiosisComponent::AudioUnitReset(AudioUnitScope pinScope, AudioUnitElemen
 		vstWantsMidi = vst->wantsMidi();
 	}
 	lastRenderSampleTime = -12345678.0;
+	silenceCountdown = 0;
+	midiOutputEventCount = 0;
+	resetFIFOs();
 }
 
 void SymbiosisComponent::AudioUnitAddRenderNotify(AURenderCallback pinProc, void *pinProcRefCon)
@@ -4766,18 +7625,47 @@ void SymbiosisComponent::AudioUnitScheduleParameters(const AudioUnitParameterEve
 {
 	SY_TRACE(SY_TRACE_AU, "AU kAudioUnitScheduleParametersSelect");
 
-	for (int i = 0; i < static_cast<int>(pinNumParamEvents); ++i) {
-		const AudioUnitParameterEvent& theEvent = (pinParameterEvent)[i];
-		if (theEvent.scope != kAudioUnitScope_Global) throw MacOSException(kAudioUnitErr_InvalidScope);
-		if (static_cast<int>(theEvent.parameter) < 0 || static_cast<int>(theEvent.parameter)
-				>= vst->getParameterCount())
-			throw MacOSException(kAudioUnitErr_InvalidParameter);
-		if (theEvent.eventType == kParameterEvent_Immediate) {
-			SY_ASSERT(0 <= static_cast<int>(theEvent.eventValues.immediate.bufferOffset)
-					&& static_cast<int>(theEvent.eventValues.immediate.bufferOffset) < maxFramesPerSlice);
-			vst->setParameter(theEvent.parameter, scaleFromAUParameter(theEvent.parameter
-					, theEvent.eventValues.immediate.value));
+	int batchParameters[kParameterEventBatchSize];
+	float batchValues[kParameterEventBatchSize];
+	int batchStart = 0;
+	while (batchStart < static_cast<int>(pinNumParamEvents)) {
+		int batchEnd = batchStart;																						// First validate and convert the values of a batch of immediate events in one pass.
+		int batchCount = 0;
+		while (batchEnd < static_cast<int>(pinNumParamEvents) && batchCount < kParameterEventBatchSize) {
+			const AudioUnitParameterEvent& theEvent = (pinParameterEvent)[batchEnd];
+			if (theEvent.scope != kAudioUnitScope_Global) throw MacOSException(kAudioUnitErr_InvalidScope);
+			if (!isMappedParameter(theEvent.parameter)) throw MacOSException(kAudioUnitErr_InvalidParameter);
+			if (theEvent.eventType == kParameterEvent_Immediate) {
+				batchParameters[batchCount] = theEvent.parameter;
+				batchValues[batchCount] = theEvent.eventValues.immediate.value;
+				++batchCount;
+			}
+			++batchEnd;
+		}
+		scaleFromAUParameters(batchCount, batchParameters, batchValues, batchValues);
+		
+		batchCount = 0;
+		for (int i = batchStart; i < batchEnd; ++i) {
+			const AudioUnitParameterEvent& theEvent = (pinParameterEvent)[i];
+			if (theEvent.eventType == kParameterEvent_Immediate) {
+				const int offset = static_cast<int>(theEvent.eventValues.immediate.bufferOffset);
+				SY_ASSERT(0 <= offset);																					// No upper bound, slices longer than maxFramesPerSlice are rendered in chunks when using the host's buffers.
+				const float value = batchValues[batchCount];
+				++batchCount;
+				scheduleParameter(offset + fifoFrames, theEvent.parameter, value);
+			} else if (theEvent.eventType == kParameterEvent_Ramped) {
+				const int durationFrames = static_cast<int>(theEvent.eventValues.ramp.durationInFrames);
+				if (durationFrames <= 0 || !vst->isResumed()) {
+					setParameterUnsmoothed(theEvent.parameter
+							, scaleFromAUParameter(theEvent.parameter, theEvent.eventValues.ramp.endValue));
+				} else {
+					scheduleParameterRamp(theEvent.parameter
+							, fifoFrames + static_cast<int>(theEvent.eventValues.ramp.startBufferOffset), durationFrames
+							, theEvent.eventValues.ramp.startValue, theEvent.eventValues.ramp.endValue);
+				}
+			}
 		}
+		batchStart = batchEnd;
 	}
 }
 
@@ -5192,8 +8080,7 @@ public:
     {
         OSStatus result = kAudioUnitErr_Uninitialized;
         try {
-            impl(self).render(ioActionFlags, inTimeStamp, inOutputBusNumber, inNumberFrames, ioData);
-            result = noErr;
+            result = impl(self).render(ioActionFlags, inTimeStamp, inOutputBusNumber, inNumberFrames, ioData);
         }
         SY_COMPONENT_CATCH("SymbiosisAUV2::AUMethodRender");
         return result;
@@ -5220,6 +8107,17 @@ public:
         SY_COMPONENT_CATCH("SymbiosisAUV2::AUMethodMIDIEvent");
         return result;
     }
+
+    static OSStatus AUMethodSysEx(void *self, const UInt8 *inData, UInt32 inLength)
+    {
+        OSStatus result = kAudioUnitErr_Uninitialized;
+        try {
+            impl(self).sysExInput(0, inData, inLength);
+            result = noErr;
+        }
+        SY_COMPONENT_CATCH("SymbiosisAUV2::AUMethodSysEx");
+        return result;
+    }
 };
 
 
@@ -5289,6 +8187,7 @@ public:
             case kAudioUnitRenderSelect:            return (AudioComponentMethod)SymbiosisAUV2::AUMethodRender;
             case kAudioUnitResetSelect:             return (AudioComponentMethod)SymbiosisAUV2::AUMethodReset;
             case kMusicDeviceMIDIEventSelect:       return (AudioComponentMethod)SymbiosisAUV2::AUMethodMIDIEvent;
+            case kMusicDeviceSysExSelect:           return (AudioComponentMethod)SymbiosisAUV2::AUMethodSysEx;
             default:
                 break;
         }
@@ -5502,7 +8401,10 @@ public:
                 PARAM(UInt32, pinNumberFrames, 3, 5);
                 PARAM(AudioBufferList *, pioData, 4, 5);
                 
-                render(pioActionFlags, pinTimeStamp, pinOutputBusNumber, pinNumberFrames, pioData);
+                ::OSStatus status = render(pioActionFlags, pinTimeStamp, pinOutputBusNumber, pinNumberFrames, pioData);
+                if (status != noErr) {
+                    throw MacOSException(status);
+                }
                 break;
             }
             
@@ -5540,6 +8442,14 @@ public:
                 break;
             }
             
+            case kMusicDeviceSysExSelect: {
+                PARAM(const UInt8 *, pinData, 0, 2);
+                PARAM(UInt32, pinLength, 1, 2);
+                
+                sysExInput(0, pinData, pinLength);
+                break;
+            }
+            
             default:
                 SY_TRACE1(SY_TRACE_AU, "AU unknown selector: %d", params->what);
                 throw MacOSException(badComponentSelector);
@@ -5568,7 +8478,7 @@ extern "C" __attribute__((visibility("default"))) ::ComponentResult SymbiosisEnt
 					case kAudioUnitAddRenderNotifySelect: case kAudioUnitRemoveRenderNotifySelect:
 					case kAudioUnitScheduleParametersSelect: case kAudioUnitRenderSelect:
 
-					case kMusicDeviceMIDIEventSelect:
+					case kMusicDeviceMIDIEventSelect: case kMusicDeviceSysExSelect:
 						
 					case kComponentOpenSelect: case kComponentCloseSelect: case kComponentVersionSelect:
 					case kComponentCanDoSelect: